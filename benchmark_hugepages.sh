@@ -0,0 +1,42 @@
+#!/bin/bash
+# Compares the dTLB behavior of the benchmarks with the cb ring backed by
+# normal pages, transparent huge pages, and 2MB hugetlbfs pages.
+#
+# Uses perf(1) where it is available, and otherwise reports wall-clock times
+# only.  The 2M mode requires a hugetlbfs mount (KLOX_HUGETLBFS_DIR,
+# default /dev/hugepages) with enough pages reserved for a 1GB ring, e.g.:
+#   echo 1024 | sudo tee /proc/sys/vm/nr_hugepages
+# The thp mode requires /sys/kernel/mm/transparent_hugepage/shmem_enabled to be
+# "advise" or "always".
+
+BIN="${1:-c/BUILD/RelWithDebInfo/klox}"
+
+BENCHMARKS=()
+BENCHMARKS+=(test/benchmark/method_call.lox)
+BENCHMARKS+=(test/benchmark/fib.lox)
+BENCHMARKS+=(test/benchmark/trees.lox)
+BENCHMARKS+=(test/benchmark/zoo.lox)
+BENCHMARKS+=(test/benchmark/properties.lox)
+BENCHMARKS+=(test/benchmark/instantiation_1GB_limit.lox)
+BENCHMARKS+=(test/benchmark/binary_trees_1GB_limit.lox)
+
+MODES=(normal thp 2M)
+
+export KLOX_RING_SIZE=1073741824  # Sufficiently pre-sized for all benchmark tests.
+
+for b in "${BENCHMARKS[@]}"
+do
+  for m in "${MODES[@]}"
+  do
+    rm -rf map-* gc-*
+    echo "${b} (KLOX_HUGEPAGES=${m})"
+    if command -v perf >/dev/null
+    then
+      KLOX_HUGEPAGES="${m}" perf stat -e task-clock,dTLB-loads,dTLB-load-misses,dTLB-store-misses "${BIN}" "${b}" >/dev/null
+    else
+      time KLOX_HUGEPAGES="${m}" "${BIN}" "${b}" >/dev/null
+    fi
+  done
+done
+
+exit 0
@@ -5,8 +5,10 @@
 #include <assert.h>
 #include <stdio.h>
 #include "compiler.h"
+#include "hashmap.h"
 #include "object.h"
 #include "memory.h"
+#include "ring.h"
 #include "value.h"
 #include "vm.h"
 #include "trace.h"
@@ -145,7 +147,7 @@ klox_Obj_external_size(const struct cb *cb,
   //NOTE: The objtable's present external size will be maintained on insertions
   // and removals of entries to it, as well as in-place mutations to its
   // contained entries.  There will be entries (in particular OBJ_CLASS,
-  // OBJ_FUNCTION, and OBJ_INSTANCE) which will have such in-place
+  // OBJ_FUNCTION, OBJ_HASHMAP, OBJ_INSTANCE, and OBJ_LIST) which will have such in-place
   // mutations.  In such cases, the objtable's tracking of its own size cannot
   // be performed solely upon insertions/removals of its contained objects;
   // additional tracking (via cb_bst_external_size_adjust()) must be done at
@@ -170,6 +172,13 @@ klox_Obj_external_size(const struct cb *cb,
         + (2 * (alloc_header_size + alloc_header_align - 1));
     }
 
+    case OBJ_F64ARRAY: {
+      ObjF64Array *array = (ObjF64Array *)obj;
+      return sizeof(ObjF64Array) + cb_alignof(ObjF64Array) - 1
+             + array->count * sizeof(double) + cb_alignof(double) - 1  //values
+             + (2 * (alloc_header_size + alloc_header_align - 1));
+    }
+
     case OBJ_FUNCTION: {
       ObjFunction *function = (ObjFunction *)obj;
       return sizeof(ObjFunction) + cb_alignof(ObjFunction) - 1
@@ -179,6 +188,13 @@ klox_Obj_external_size(const struct cb *cb,
              + (4 * (alloc_header_size + alloc_header_align - 1));
     }
 
+    case OBJ_HASHMAP: {
+      ObjHashMap *map = (ObjHashMap *)obj;
+      return sizeof(ObjHashMap) + cb_alignof(ObjHashMap) - 1
+             + hashMapStorageCount(map->capacity) * sizeof(HashMapEntry) + cb_alignof(HashMapEntry) - 1  //entries
+             + (2 * (alloc_header_size + alloc_header_align - 1));
+    }
+
     case OBJ_INSTANCE: {
       ObjInstance *instance = (ObjInstance *)obj;
       return sizeof(ObjInstance) + cb_alignof(ObjInstance) - 1
@@ -186,6 +202,22 @@ klox_Obj_external_size(const struct cb *cb,
              + alloc_header_size + alloc_header_align - 1;
     }
 
+    case OBJ_LIST: {
+      ObjList *list = (ObjList *)obj;
+      return sizeof(ObjList) + cb_alignof(ObjList) - 1
+             + list->capacity * sizeof(Value) + cb_alignof(Value) - 1  //values
+             + (2 * (alloc_header_size + alloc_header_align - 1));
+    }
+
+    case OBJ_MAP: {
+      //NOTE: Nodes shared with other versions of this map are counted in full
+      // here, as consolidation will give each surviving version its own copy.
+      ObjMap *map = (ObjMap *)obj;
+      return sizeof(ObjMap) + cb_alignof(ObjMap) - 1
+             + cb_bst_size(cb, map->root)
+             + alloc_header_size + alloc_header_align - 1;
+    }
+
     case OBJ_NATIVE:
       return sizeof(ObjNative) + cb_alignof(ObjNative) - 1
         + alloc_header_size + alloc_header_align - 1;
@@ -206,8 +238,12 @@ klox_Obj_external_size(const struct cb *cb,
       assert(obj->type == OBJ_BOUND_METHOD
              || obj->type == OBJ_CLASS
              || obj->type == OBJ_CLOSURE
+             || obj->type == OBJ_F64ARRAY
              || obj->type == OBJ_FUNCTION
+             || obj->type == OBJ_HASHMAP
              || obj->type == OBJ_INSTANCE
+             || obj->type == OBJ_LIST
+             || obj->type == OBJ_MAP
              || obj->type == OBJ_NATIVE
              || obj->type == OBJ_STRING
              || obj->type == OBJ_UPVALUE);
@@ -255,6 +291,7 @@ klox_objtable_value_render(cb_offset_t           *dest_offset,
   cb_offset_t allocation_offset = (cb_offset_t)cb_term_get_u64(term);
   char *mem = (char *)cb_at(*cb, allocation_offset);
 
+#ifndef NDEBUG
   assert(alloc_is_object_get(mem));
 
   return cb_asprintf(dest_offset, cb, "@%ju<s:%ju,a:%ju,ObjType:%d>",
@@ -262,6 +299,11 @@ klox_objtable_value_render(cb_offset_t           *dest_offset,
                      (uintmax_t)alloc_size_get(mem),
                      (uintmax_t)alloc_alignment_get(mem),
                      (int)((Obj *)mem)->type);
+#else
+  return cb_asprintf(dest_offset, cb, "@%ju<ObjType:%d>",
+                     (uintmax_t)allocation_offset,
+                     (int)((Obj *)mem)->type);
+#endif
 
 }
 
@@ -344,6 +386,19 @@ fields_layer_init(struct cb **cb, struct cb_region *region, FieldsSM *sm) {
   return 0;
 }
 
+int
+map_bst_init(struct cb **cb, struct cb_region *region, cb_offset_t *root) {
+  return cb_bst_init(cb,
+                     region,
+                     root,
+                     &klox_map_key_comparator,
+                     &klox_map_value_deep_comparator,
+                     &klox_value_render,
+                     &klox_value_render,
+                     &klox_no_external_size,
+                     &klox_no_external_size);
+}
+
 void
 objtable_init(ObjTable *obj_table, struct cb *cb, cb_offset_t a_offset, cb_offset_t b_offset, cb_offset_t c_offset)
 {
@@ -445,8 +500,20 @@ objtable_consolidation_size(ObjTable *obj_table)
          b_external_size, b_internal_size, c_external_size, c_internal_size, ObjTableSM::MODIFICATION_MAX_SIZE, addl_size);
 
   //NOTE: All objtablelayer's structmaps must have the same number of firstlevel bits.
-  //NOTE: One MODIFICATION_MAX_SIZE encompasses the space need for the mutations themselves. The other is because the GC itself will *also* reserve MODIFICATION_MAX_SIZE on insertion.
-  return b_external_size + b_internal_size + c_external_size + c_internal_size + (2 * ObjTableSM::MODIFICATION_MAX_SIZE) + addl_size;
+  return b_external_size + b_internal_size + c_external_size + c_internal_size + objtable_consolidation_margin() + addl_size;
+}
+
+size_t
+objtable_consolidation_margin(void)
+{
+  //NOTE: Beyond the entries' own sizes, objtable_consolidation_size() reserves
+  // this much, and each entry is only consolidated while its own size plus this
+  // much remains.  One MODIFICATION_MAX_SIZE covers the entry's insertion into
+  // the new B layer, the other the structmap modification reserved while
+  // cloning or merging an ObjClass's methods or an ObjInstance's fields.
+  static_assert(MethodsSM::MODIFICATION_MAX_SIZE <= 2 * ObjTableSM::MODIFICATION_MAX_SIZE, "");
+  static_assert(FieldsSM::MODIFICATION_MAX_SIZE <= 2 * ObjTableSM::MODIFICATION_MAX_SIZE, "");
+  return 2 * ObjTableSM::MODIFICATION_MAX_SIZE;
 }
 
 cb_offset_t
@@ -463,6 +530,51 @@ objtable_lookup(ObjTable *obj_table, ObjID obj_id)
   return CB_NULL;
 }
 
+void
+objtable_lookup_batch(ObjTable *obj_table, const ObjID *obj_ids, cb_offset_t *offsets, unsigned int n)
+{
+  //NOTE: Equivalent to objtable_lookup() of each of the obj_ids, but with the
+  // lookups of (up to) ObjTableSM::LOOKUP_BATCH_MAX keys interleaved per layer.
+  // Those keys not resolved by the A layer are regathered and tried in B, and
+  // those not resolved by B are likewise tried in C.
+  ObjTableLayer *layers[] = { &(obj_table->a), &(obj_table->b), &(obj_table->c) };
+
+  while (n > 0) {
+    unsigned int chunk = (n < ObjTableSM::LOOKUP_BATCH_MAX ? n : ObjTableSM::LOOKUP_BATCH_MAX);
+    uint64_t keys[ObjTableSM::LOOKUP_BATCH_MAX];
+    uint64_t values[ObjTableSM::LOOKUP_BATCH_MAX];
+    bool found[ObjTableSM::LOOKUP_BATCH_MAX];
+    unsigned int slot[ObjTableSM::LOOKUP_BATCH_MAX];
+    unsigned int pending = chunk;
+
+    for (unsigned int i = 0; i < chunk; ++i) {
+      keys[i] = obj_ids[i].id;
+      slot[i] = i;
+      offsets[i] = CB_NULL;
+    }
+
+    for (unsigned int l = 0; l < sizeof(layers) / sizeof(layers[0]) && pending > 0; ++l) {
+      unsigned int remaining = 0;
+
+      objtablelayer_lookup_batch(thread_cb, layers[l], pending, keys, values, found);
+      for (unsigned int i = 0; i < pending; ++i) {
+        if (found[i]) {
+          offsets[slot[i]] = PURE_OFFSET((cb_offset_t)values[i]);
+        } else {
+          keys[remaining] = keys[i];
+          slot[remaining] = slot[i];
+          ++remaining;
+        }
+      }
+      pending = remaining;
+    }
+
+    obj_ids += chunk;
+    offsets += chunk;
+    n -= chunk;
+  }
+}
+
 cb_offset_t
 objtable_lookup_A(ObjTable *obj_table, ObjID obj_id)
 {
@@ -607,6 +719,23 @@ klox_object_deep_cmp(const Obj *lhs, const Obj *rhs)
       return 0;
     }
 
+    case OBJ_F64ARRAY: {
+      const ObjF64Array *l = (const ObjF64Array*)lhs;
+      const ObjF64Array *r = (const ObjF64Array*)rhs;
+      int cmp;
+
+      if (l->count < r->count) return -1;
+      if (l->count > r->count) return 1;
+
+      if (l->count == 0) return 0;
+
+      cmp = memcmp(l->values.clp().cp(), r->values.clp().cp(), l->count * sizeof(double));
+      if (cmp < 0) return -1;
+      if (cmp > 0) return 1;
+
+      return 0;
+    }
+
     case OBJ_FUNCTION: {
       const ObjFunction *l = (const ObjFunction*)lhs;
       const ObjFunction *r = (const ObjFunction*)rhs;
@@ -645,6 +774,39 @@ klox_object_deep_cmp(const Obj *lhs, const Obj *rhs)
       return 0;
     }
 
+    case OBJ_HASHMAP: {
+      const ObjHashMap *l = (const ObjHashMap*)lhs;
+      const ObjHashMap *r = (const ObjHashMap*)rhs;
+      int cmp;
+
+      if (l->count < r->count) return -1;
+      if (l->count > r->count) return 1;
+
+      if (l->capacity < r->capacity) return -1;
+      if (l->capacity > r->capacity) return 1;
+
+      if (l->capacity == 0) return 0;
+
+      const HashMapEntry *le = l->entries.clp().cp();
+      const HashMapEntry *re = r->entries.clp().cp();
+      const uint8_t *lctrl = hashMapCtrl(le, l->capacity);
+      const uint8_t *rctrl = hashMapCtrl(re, r->capacity);
+
+      cmp = memcmp(lctrl, rctrl, l->capacity);
+      if (cmp < 0) return -1;
+      if (cmp > 0) return 1;
+
+      for (int i = 0; i < l->capacity; ++i) {
+        if (!hashMapCtrlIsFull(lctrl[i])) continue;
+        cmp = klox_value_deep_cmp(le[i].key, re[i].key);
+        if (cmp != 0) return cmp;
+        cmp = klox_value_deep_cmp(le[i].value, re[i].value);
+        if (cmp != 0) return cmp;
+      }
+
+      return 0;
+    }
+
     case OBJ_INSTANCE: {
       const ObjInstance *l = (const ObjInstance*)lhs;
       const ObjInstance *r = (const ObjInstance*)rhs;
@@ -655,6 +817,34 @@ klox_object_deep_cmp(const Obj *lhs, const Obj *rhs)
       return l->fields_sm.compare(r->fields_sm, &value_cmp);
     }
 
+    case OBJ_LIST: {
+      const ObjList *l = (const ObjList*)lhs;
+      const ObjList *r = (const ObjList*)rhs;
+      int cmp;
+
+      if (l->count < r->count) return -1;
+      if (l->count > r->count) return 1;
+
+      const Value *lv = l->values.clp().cp();
+      const Value *rv = r->values.clp().cp();
+      for (int i = 0; i < l->count; ++i) {
+        cmp = klox_value_deep_cmp(lv[i], rv[i]);
+        if (cmp != 0) return cmp;
+      }
+
+      return 0;
+    }
+
+    case OBJ_MAP: {
+      const ObjMap *l = (const ObjMap*)lhs;
+      const ObjMap *r = (const ObjMap*)rhs;
+
+      if (l->count < r->count) return -1;
+      if (l->count > r->count) return 1;
+
+      return cb_bst_cmp(thread_cb, l->root, r->root);
+    }
+
     case OBJ_NATIVE: {
       const ObjNative *l = (const ObjNative*)lhs;
       const ObjNative *r = (const ObjNative*)rhs;
@@ -720,8 +910,12 @@ klox_object_deep_cmp(const Obj *lhs, const Obj *rhs)
       assert(lhs->type == OBJ_BOUND_METHOD
              || lhs->type == OBJ_CLASS
              || lhs->type == OBJ_CLOSURE
+             || lhs->type == OBJ_F64ARRAY
              || lhs->type == OBJ_FUNCTION
+             || lhs->type == OBJ_HASHMAP
              || lhs->type == OBJ_INSTANCE
+             || lhs->type == OBJ_LIST
+             || lhs->type == OBJ_MAP
              || lhs->type == OBJ_NATIVE
              || lhs->type == OBJ_STRING
              || lhs->type == OBJ_UPVALUE);
@@ -841,6 +1035,68 @@ klox_value_shallow_comparator(const struct cb *cb,
   return 0;
 }
 
+//NOTE: This variant is for the values of ObjMap BSTs, which may hold
+//  TOMBSTONE_VAL for removed keys.
+int
+klox_map_value_deep_comparator(const struct cb *cb,
+                               const struct cb_term *lhs,
+                               const struct cb_term *rhs)
+{
+  // We expect to only use the double value of cb_terms.
+  assert(lhs->tag == CB_TERM_DBL);
+  assert(rhs->tag == CB_TERM_DBL);
+
+  Value lhs_val = numToValue(cb_term_get_dbl(lhs));
+  Value rhs_val = numToValue(cb_term_get_dbl(rhs));
+
+  // Tombstones order before all other values.
+  if (lhs_val.val == TOMBSTONE_VAL.val || rhs_val.val == TOMBSTONE_VAL.val) {
+    if (lhs_val.val == rhs_val.val) return 0;
+    return (lhs_val.val == TOMBSTONE_VAL.val ? -1 : 1);
+  }
+
+  return klox_value_deep_cmp(lhs_val, rhs_val);
+}
+
+//NOTE: This variant is for the keys of ObjMap BSTs.  Numbers and strings are
+//  ordered by value, whereas all other objects are ordered by identity, as
+//  their contents may be mutated after their use as keys.
+int
+klox_map_key_comparator(const struct cb *cb,
+                        const struct cb_term *lhs,
+                        const struct cb_term *rhs)
+{
+  // We expect to only use the double value of cb_terms.
+  assert(lhs->tag == CB_TERM_DBL);
+  assert(rhs->tag == CB_TERM_DBL);
+
+  Value lhs_val = numToValue(cb_term_get_dbl(lhs));
+  Value rhs_val = numToValue(cb_term_get_dbl(rhs));
+  ValueType lhs_valtype = getValueType(lhs_val);
+  ValueType rhs_valtype = getValueType(rhs_val);
+
+  if (lhs_valtype < rhs_valtype) return -1;
+  if (lhs_valtype > rhs_valtype) return 1;
+
+  if (lhs_valtype == VAL_NUMBER) {
+    //NOTE: 0 and -0 are the same key, as per valuesEqual().
+    if (AS_NUMBER(lhs_val) == AS_NUMBER(rhs_val)) return 0;
+  }
+
+  if (lhs_valtype != VAL_OBJ)
+    return klox_value_deep_cmp(lhs_val, rhs_val);
+
+  bool lhs_is_string = (OBJ_TYPE(lhs_val) == OBJ_STRING);
+  bool rhs_is_string = (OBJ_TYPE(rhs_val) == OBJ_STRING);
+
+  if (lhs_is_string != rhs_is_string) return (lhs_is_string ? -1 : 1);
+  if (lhs_is_string) return klox_value_deep_cmp(lhs_val, rhs_val);
+
+  if (AS_OBJ_ID(lhs_val).id < AS_OBJ_ID(rhs_val).id) return -1;
+  if (AS_OBJ_ID(lhs_val).id > AS_OBJ_ID(rhs_val).id) return 1;
+  return 0;
+}
+
 //NOTE: This variant would be used when deeply comparing BSTs (via cb_bst_cmp()),
 //  on BSTs where the values are the same as the keys.
 int
@@ -872,10 +1128,18 @@ klox_object_render(cb_offset_t           *dest_offset,
       return cb_asprintf(dest_offset, cb, "<class@%ju>", (uintmax_t)AS_CLASS_OID(value).id().id);
     case OBJ_CLOSURE:
       return cb_asprintf(dest_offset, cb, "<closure@%ju>", (uintmax_t)AS_CLOSURE_OID(value).id().id);
+    case OBJ_F64ARRAY:
+      return cb_asprintf(dest_offset, cb, "<f64array@%ju>", (uintmax_t)AS_F64ARRAY_OID(value).id().id);
     case OBJ_FUNCTION:
       return cb_asprintf(dest_offset, cb, "<fun@%ju>", (uintmax_t)AS_FUNCTION_OID(value).id().id);
+    case OBJ_HASHMAP:
+      return cb_asprintf(dest_offset, cb, "<hashmap@%ju>", (uintmax_t)AS_HASHMAP_OID(value).id().id);
     case OBJ_INSTANCE:
       return cb_asprintf(dest_offset, cb, "<instance@%ju>", (uintmax_t)AS_INSTANCE_OID(value).id().id);
+    case OBJ_LIST:
+      return cb_asprintf(dest_offset, cb, "<list@%ju>", (uintmax_t)AS_LIST_OID(value).id().id);
+    case OBJ_MAP:
+      return cb_asprintf(dest_offset, cb, "<map@%ju>", (uintmax_t)AS_MAP_OID(value).id().id);
     case OBJ_NATIVE:
       return cb_asprintf(dest_offset, cb, "<nativefun%p>", (void*)AS_NATIVE(value));
     case OBJ_STRING:{
@@ -907,8 +1171,12 @@ klox_object_render(cb_offset_t           *dest_offset,
       assert(objType == OBJ_BOUND_METHOD
              || objType == OBJ_CLASS
              || objType == OBJ_CLOSURE
+             || objType == OBJ_F64ARRAY
              || objType == OBJ_FUNCTION
+             || objType == OBJ_HASHMAP
              || objType == OBJ_INSTANCE
+             || objType == OBJ_LIST
+             || objType == OBJ_MAP
              || objType == OBJ_NATIVE
              || objType == OBJ_STRING
              || objType == OBJ_UPVALUE);
@@ -955,6 +1223,7 @@ klox_on_cb_preresize(struct cb *old_cb, struct cb *new_cb)
 {
   KLOX_TRACE("Pre-RESIZE\n");
   assert(on_main_thread);
+  ring_resize_begin();
 
   // Convert each frame to temporarily hold it's ip_offset instead of a raw
   // ip pointer.  The frames will be converted back to new raw ip pointers
@@ -978,6 +1247,7 @@ klox_on_cb_resize(struct cb *old_cb, struct cb *new_cb)
   KLOX_TRACE("~~~~~~~~~~~~RESIZED from %ju to %ju (gc_outstanding? %d, old_cb: %p, new_cb: %p, thread_cb: %p)~~~~~~~~~~~\n",
           (uintmax_t)cb_ring_size(old_cb), (uintmax_t)cb_ring_size(new_cb), gc_request_is_outstanding, old_cb, new_cb, thread_cb);
 
+  ring_advise(new_cb);
   tristack_recache(&(vm.tristack), new_cb);
 
   if (vm.currentFrame) {
@@ -1034,14 +1304,17 @@ klox_on_cb_resize(struct cb *old_cb, struct cb *new_cb)
   thread_cb_at_immed_param.ring_mask = cb_ring_mask(new_cb);
   is_resizing = false;
 
+  ring_resize_end(old_cb, new_cb);
   KLOX_TRACE("~~~~~RESIZE COMPLETE~~~~~\n");
 }
 
 void
 gc_submit_request(struct gc_request_response *rr) {
   KLOX_TRACE("Submitting GC request %p  (gc_last_processed_response:%p)\n", rr, gc_last_processed_response);
+  //NOTE: With KLOX_SYNC_GC, the GC thread traces from the moment it sees the
+  // request until it responds, so nothing is traced here in the meantime, lest
+  // the two threads' partial trace lines interleave.
   gc_current_request.store(rr, std::memory_order_release);
-  KLOX_TRACE("Submitted GC request %p (gc_last_processed_response:%p)\n", rr, gc_last_processed_response);
   gc_request_is_outstanding = true;
 }
 
@@ -1056,7 +1329,9 @@ struct gc_request_response *
 gc_await_response(void) {
   struct gc_request_response *rr;
 
+#if !KLOX_SYNC_GC
   KLOX_TRACE("Awaiting GC response (gc_last_processed_response:%p)\n", gc_last_processed_response);
+#endif //!KLOX_SYNC_GC
   do {
     rr = gc_current_response.load(std::memory_order_acquire);
   } while (rr == gc_last_processed_response);
@@ -1087,6 +1362,13 @@ integrate_any_gc_response(void) {
   KLOX_TRACE("Received on main thread a newer gc_request_response (%p) than our last one (%p)\n",
              rr1, gc_last_processed_response);
 
+  if (rr2->resp.objtable_overflowed) {
+    KLOX_TRACE("setting gc_last_processed_response to overflowed %p\n", rr2);
+    gc_last_processed_response = rr2;
+    retryOverflowedGCRequest();
+    return;
+  }
+
   integrateGCResponse(rr2);
 
   KLOX_TRACE("setting gc_last_processed_response to %p\n", rr2);
@@ -1276,8 +1558,33 @@ struct copy_objtable_closure
   DEBUG_ONLY(size_t last_new_b_internal_size);
   DEBUG_ONLY(size_t last_new_b_size);
   ObjID             white_list;
+  bool              overflowed;
+  unsigned int      c_pending_count;
+  uint64_t          c_pending_keys[ObjTableSM::LOOKUP_BATCH_MAX];
+  uint64_t          c_pending_vals[ObjTableSM::LOOKUP_BATCH_MAX];
 };
 
+static bool
+copy_objtable_would_overflow(struct copy_objtable_closure *cl,
+                             cb_offset_t                   offset)
+{
+  //NOTE: The destination region is reserved from the size the previous
+  // consolidations actually needed rather than from the worst case, so it may
+  // fall short.  Rather than run out of it partway through an entry, we stop
+  // consolidating once an entry might not fit, and the main thread resubmits
+  // the request with a worst-case region (see retryOverflowedGCRequest()).
+  // The bound per entry is the one objtable_consolidation_size() accounts for,
+  // so that a worst-case region never falls short.
+  if (!cl->overflowed
+      && (size_t)(cb_region_end(cl->dest_region) - cb_region_cursor(cl->dest_region))
+           < klox_allocation_size(cl->src_cb, offset) + objtable_consolidation_margin()) {
+    KLOX_TRACE("objtable consolidation overflowed its destination region at @%ju.\n", (uintmax_t)offset);
+    cl->overflowed = true;
+  }
+
+  return cl->overflowed;
+}
+
 static int
 copy_objtable_b(uint64_t  key,
                 uint64_t  val,
@@ -1312,6 +1619,9 @@ copy_objtable_b(uint64_t  key,
     newly_white = true;
   }
 
+  if (copy_objtable_would_overflow(cl, offset))
+    return 0;
+
   DEBUG_ONLY(cb_offset_t c0 = cb_region_cursor(cl->dest_region));
 
   bool did_dedupe = !newly_white && dedupeObject(&offset);
@@ -1375,10 +1685,12 @@ copy_objtable_b(uint64_t  key,
   return 0;
 }
 
-static int
-copy_objtable_c_not_in_b(uint64_t  key,
-                         uint64_t  val,
-                         void     *closure)
+static void
+copy_objtable_c_entry(struct copy_objtable_closure *cl,
+                      uint64_t                      key,
+                      uint64_t                      val,
+                      bool                          in_b,
+                      uint64_t                      b_val)
 {
   //NOTE: For #ObjID keys which do not exist in B, this is simply copying the
   // #ObjID -> @offset mapping into a cb_bst which already contains the entries
@@ -1387,12 +1699,10 @@ copy_objtable_c_not_in_b(uint64_t  key,
   // ObjInstance's fields), a new Obj must be created to contain the merged set
   // of these contents.
 
-  struct copy_objtable_closure *cl = (struct copy_objtable_closure *)closure;
   OID<Obj> objOID = (ObjID) { .id = key };
   cb_offset_t cEntryOffset = PURE_OFFSET((cb_offset_t)val);
   bool already_white = ALREADY_WHITE((cb_offset_t)val);
   bool newly_white = false;
-  uint64_t temp_val = 0;
   ssize_t external_size_adjustment = 0;
   int ret;
 
@@ -1404,13 +1714,16 @@ copy_objtable_c_not_in_b(uint64_t  key,
   if (!objectIsDark(objOID)) {
     if (already_white) {
       KLOX_TRACE("skipping already white object #%ju.\n", (uintmax_t)objOID.id().id);
-      return 0;
+      return;
     } else {
       KLOX_TRACE("preserving newly white object #%ju.\n", (uintmax_t)objOID.id().id);
       newly_white = true;
     }
   }
 
+  if (copy_objtable_would_overflow(cl, cEntryOffset))
+    return;
+
   cb_offset_t dest_offset = cEntryOffset;
 
   DEBUG_ONLY(size_t external_used_bytes = 0);
@@ -1420,8 +1733,8 @@ copy_objtable_c_not_in_b(uint64_t  key,
   // If an entry exists in both B and C, B's entry should mask C's EXCEPT when
   // the B entry and C entry can be merged (which is when they are both ObjClass
   // or both ObjInstance objects).
-  if (objtablelayer_lookup(cl->src_cb, cl->new_b, key, &temp_val) == true) {
-    cb_offset_t bEntryOffset = (cb_offset_t)temp_val;
+  if (in_b) {
+    cb_offset_t bEntryOffset = (cb_offset_t)b_val;
     CBO<Obj> bEntryObj = bEntryOffset;
     CBO<Obj> cEntryObj = cEntryOffset;
 
@@ -1484,7 +1797,7 @@ copy_objtable_c_not_in_b(uint64_t  key,
     } else {
       // B's entry masks C's, so skip C's entry.
       // (We are presently traversing C's entries.)
-      return 0;
+      return;
     }
   } else {
     //Nothing in B masks the presently-traversed entry in C, just insert
@@ -1558,6 +1871,37 @@ copy_objtable_c_not_in_b(uint64_t  key,
   DEBUG_ONLY(cl->last_new_b_size = new_b_size);
 
   (void)ret;
+}
+
+static void
+copy_objtable_c_pending(struct copy_objtable_closure *cl)
+{
+  uint64_t b_vals[ObjTableSM::LOOKUP_BATCH_MAX];
+  bool in_b[ObjTableSM::LOOKUP_BATCH_MAX];
+
+  //NOTE: Inserting one #ObjID into new_b does not disturb the lookup results
+  // already obtained for the other (distinct) #ObjIDs of the batch.
+  objtablelayer_lookup_batch(cl->src_cb, cl->new_b, cl->c_pending_count, cl->c_pending_keys, b_vals, in_b);
+  for (unsigned int i = 0; i < cl->c_pending_count; ++i) {
+    copy_objtable_c_entry(cl, cl->c_pending_keys[i], cl->c_pending_vals[i], in_b[i], b_vals[i]);
+  }
+  cl->c_pending_count = 0;
+}
+
+static int
+copy_objtable_c_not_in_b(uint64_t  key,
+                         uint64_t  val,
+                         void     *closure)
+{
+  //NOTE: C's entries are gathered into batches so that their lookups into B
+  // may be interleaved.  The final partial batch must be flushed by the caller
+  // with copy_objtable_c_pending().
+  struct copy_objtable_closure *cl = (struct copy_objtable_closure *)closure;
+
+  cl->c_pending_keys[cl->c_pending_count] = key;
+  cl->c_pending_vals[cl->c_pending_count] = val;
+  if (++cl->c_pending_count == ObjTableSM::LOOKUP_BATCH_MAX) copy_objtable_c_pending(cl);
+
   return 0;
 }
 
@@ -1864,9 +2208,10 @@ gc_perform(struct gc_request_response *rr)
   // Traverse the references.
   gc_phase = GC_PHASE_MARK_ALL_LEAVES;
   while (gc.grayCount > 0) {
-    // Pop an item from the gray stack.
-    OID<Obj> object = gc.grayStack.clp().cp()[--gc.grayCount];
-    grayObjectLeaves(object);
+    // Pop a batch of items from the gray stack.
+    unsigned int n = (gc.grayCount < GRAY_LEAVES_BATCH_MAX ? gc.grayCount : GRAY_LEAVES_BATCH_MAX);
+    gc.grayCount -= n;
+    grayObjectLeaves(gc.grayStack.clp().cp() + gc.grayCount, n);
   }
 
   gc_phase = GC_PHASE_CONSOLIDATE;
@@ -1903,6 +2248,8 @@ gc_perform(struct gc_request_response *rr)
     DEBUG_ONLY(closure.last_new_b_internal_size = objtablelayer_internal_size(&(rr->resp.objtable_new_b)));
     DEBUG_ONLY(closure.last_new_b_size = objtablelayer_size(&(rr->resp.objtable_new_b)));
     closure.white_list  = CB_NULL_OID;
+    closure.overflowed  = false;
+    closure.c_pending_count = 0;
 
     KLOX_TRACE("condense objtable 2:  new_root_b: %ju\n", (uintmax_t)rr->resp.objtable_new_b.sm->root_node_offset);
 
@@ -1924,6 +2271,7 @@ gc_perform(struct gc_request_response *rr)
                                  copy_objtable_c_not_in_b,
                                  &closure);
     assert(ret == 0);
+    copy_objtable_c_pending(&closure);
     KLOX_TRACE("condense objtable 4:  new_root_b: %ju\n", (uintmax_t)rr->resp.objtable_new_b.sm->root_node_offset);
     KLOX_TRACE("done with copy_objtable_c_not_in_b() [s:%ju, c:%ju, e:%ju], used size: %ju\n",
                (uintmax_t)cb_region_start(&(rr->req.objtable_new_region)),
@@ -1933,6 +2281,13 @@ gc_perform(struct gc_request_response *rr)
 
     rr->resp.preserved_objects_count = gc.grayCountTotal;
     rr->resp.white_list = closure.white_list;
+
+    //NOTE: Nothing of an overflowed response gets integrated, so don't bother
+    // condensing the rest.
+    if (closure.overflowed) {
+      rr->resp.objtable_overflowed = true;
+      return 0;
+    }
   }
 
   //Condense tristack
@@ -307,8 +307,26 @@ objtablelayer_lookup(const struct cb *cb,
   return (layer->sm->lookup(cb, key, value) && *value != CB_NULL);
 }
 
+//NOTE: found[i] is false for invalidated (CB_NULL) entries, just as
+// objtablelayer_lookup() would return.
+extern inline void
+objtablelayer_lookup_batch(const struct cb *cb,
+                           ObjTableLayer   *layer,
+                           unsigned int     n,
+                           const uint64_t  *keys,
+                           uint64_t        *values,
+                           bool            *found)
+{
+  assert(layer->sm == (ObjTableSM*)cb_at(cb, layer->sm_offset));
+  layer->sm->lookup_batch(cb, n, keys, values, found);
+  for (unsigned int i = 0; i < n; ++i) {
+    if (found[i] && values[i] == CB_NULL) found[i] = false;
+  }
+}
+
 int methods_layer_init(struct cb **cb, struct cb_region *region, MethodsSM *sm);
 int fields_layer_init(struct cb **cb, struct cb_region *region, FieldsSM *sm);
+int map_bst_init(struct cb **cb, struct cb_region *region, cb_offset_t *root);
 
 void objtable_init(ObjTable *obj_table, struct cb *cb, cb_offset_t a_offset, cb_offset_t b_offset, cb_offset_t c_offset);
 void objtable_recache(ObjTable *obj_table, struct cb *cb);
@@ -318,10 +336,12 @@ cb_offset_t objtable_lookup(ObjTable *obj_table, ObjID obj_id);
 cb_offset_t objtable_lookup_A(ObjTable *obj_table, ObjID obj_id);
 cb_offset_t objtable_lookup_B(ObjTable *obj_table, ObjID obj_id);
 cb_offset_t objtable_lookup_C(ObjTable *obj_table, ObjID obj_id);
+void objtable_lookup_batch(ObjTable *obj_table, const ObjID *obj_ids, cb_offset_t *offsets, unsigned int n);
 void objtable_invalidate(ObjTable *obj_table, ObjID obj_id);
 void objtable_external_size_adjust_A(ObjTable *obj_table, ssize_t adjustment);
 void objtable_freeze(ObjTable *obj_table, struct cb **cb, struct cb_region *region);
 size_t objtable_consolidation_size(ObjTable *obj_table);
+size_t objtable_consolidation_margin(void);
 
 
 #define CB_NULL_OID ((ObjID) { 0 })
@@ -454,6 +474,16 @@ klox_value_shallow_comparator(const struct cb *cb,
                               const struct cb_term *lhs,
                               const struct cb_term *rhs);
 
+int
+klox_map_key_comparator(const struct cb *cb,
+                        const struct cb_term *lhs,
+                        const struct cb_term *rhs);
+
+int
+klox_map_value_deep_comparator(const struct cb *cb,
+                               const struct cb_term *lhs,
+                               const struct cb_term *rhs);
+
 int
 klox_null_comparator(const struct cb *cb,
                      const struct cb_term *lhs,
@@ -482,6 +512,8 @@ struct gc_request
   struct cb        *orig_cb;
   cb_offset_t       gc_dest_region_start;
   cb_offset_t       gc_dest_region_end;
+  cb_offset_t       gc_retry_region_start;  //objtable_new_region of a retried request
+  cb_offset_t       gc_retry_region_end;    // lies outside of gc_dest_region.
   cb_offset_t       new_lower_bound;
   size_t            bytes_allocated_before_gc;
   int               exec_phase;
@@ -495,6 +527,7 @@ struct gc_request
   struct cb_region  objtable_blank_region;
   struct cb_region  objtable_firstlevel_new_region;
   struct cb_region  objtable_new_region;
+  size_t            objtable_worst_size;  //objtable_new_region may be smaller.
   ObjTableLayer     objtable_b;
   ObjTableLayer     objtable_c;
 
@@ -539,6 +572,7 @@ struct gc_request
 
 struct gc_response
 {
+  bool          objtable_overflowed;
   cb_offset_t   objtable_blank_firstlevel_offset;
   ObjTableLayer objtable_new_b;
 
@@ -37,18 +37,22 @@ void writeChunk(OID<Obj> f, uint8_t byte, int line) {
     newLines = GROW_ARRAY(cfun.cp()->chunk.lines.co(), int,
         oldCapacity, newCapacity);
     hasNewArrays = true;
+  }
+
+  ObjFunction *mfun = (ObjFunction *)f.mlip().mp();
+  Chunk *mchunk = &(mfun->chunk);
 
+  if (hasNewArrays) {
     //NOTE: Because this chunk extension is done to an chunk already present
     // in the objtable (it is held by an ObjFunction, which is held in the
     // objtable), we must manually inform the objtable of this independent
-    // mutation of external size.
+    // mutation of external size.  This is only done once the mutable layer
+    // has been derived, as deriving it may provoke a GC, which would freeze
+    // the adjusted A layer without the ObjFunction in it.
     objtable_external_size_adjust_A(&thread_objtable,
-                                    (newCapacity - oldCapacity) * (sizeof(uint8_t) + sizeof(int)));
+                                    (newCapacity - mchunk->capacity) * (sizeof(uint8_t) + sizeof(int)));
   }
 
-  ObjFunction *mfun = (ObjFunction *)f.mlip().mp();
-  Chunk *mchunk = &(mfun->chunk);
-
   mchunk->capacity = newCapacity;
   if (hasNewArrays) {
     mchunk->code = newCode;
@@ -76,18 +80,22 @@ int addConstant(OID<Obj> f, Value value) {
     newValues = GROW_ARRAY(cchunk->constants.values.co(), Value,
                            oldCapacity, newCapacity);
     hasNewArray = true;
+  }
+
+  ObjFunction *mfun = (ObjFunction *)f.mlip().mp();
+  Chunk *mchunk = &(mfun->chunk);
 
+  if (hasNewArray) {
     //NOTE: Because this constants extension is done to an chunk already present
     // in the objtable (it is held by an ObjFunction, which is held in the
     // objtable), we must manually inform the objtable of this independent
-    // mutation of external size.
+    // mutation of external size.  This is only done once the mutable layer
+    // has been derived, as deriving it may provoke a GC, which would freeze
+    // the adjusted A layer without the ObjFunction in it.
     objtable_external_size_adjust_A(&thread_objtable,
-                                    (newCapacity - oldCapacity) * sizeof(Value));
+                                    (newCapacity - mchunk->constants.capacity) * sizeof(Value));
   }
 
-  ObjFunction *mfun = (ObjFunction *)f.mlip().mp();
-  Chunk *mchunk = &(mfun->chunk);
-
   mchunk->constants.capacity = newCapacity;
   if (hasNewArray)
     mchunk->constants.values = newValues;
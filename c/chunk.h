@@ -42,7 +42,10 @@ typedef enum {
   OP_RETURN,
   OP_CLASS,
   OP_INHERIT,
-  OP_METHOD
+  OP_METHOD,
+  OP_BUILD_LIST,
+  OP_GET_INDEX,
+  OP_SET_INDEX
 } OpCode;
 
 typedef struct {
@@ -168,6 +168,12 @@ int disassembleInstruction(const Chunk* chunk, int offset) {
       return simpleInstruction("OP_INHERIT", offset);
     case OP_METHOD:
       return constantInstruction("OP_METHOD", chunk, offset);
+    case OP_BUILD_LIST:
+      return byteInstruction("OP_BUILD_LIST", chunk, offset);
+    case OP_GET_INDEX:
+      return simpleInstruction("OP_GET_INDEX", offset);
+    case OP_SET_INDEX:
+      return simpleInstruction("OP_SET_INDEX", offset);
     default:
       KLOX_TRACE("Unknown opcode %d\n", instruction);
       return offset + 1;
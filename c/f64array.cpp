@@ -0,0 +1,269 @@
+#include <assert.h>
+#include <math.h>
+#include <algorithm>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define KLOX_F64_X86 1
+#include <immintrin.h>
+#endif
+
+#include "f64array.h"
+
+#if KLOX_F64_X86
+static bool haveAvx2() {
+  static const bool have = __builtin_cpu_supports("avx2");
+  return have;
+}
+#endif
+
+// Scalar kernels.  These also finish off the tails left by the vector kernels.
+
+static double sumScalar(const double *a, int n) {
+  double sum = 0;
+  for (int i = 0; i < n; ++i) sum += a[i];
+  return sum;
+}
+
+static double dotScalar(const double *a, const double *b, int n) {
+  double sum = 0;
+  for (int i = 0; i < n; ++i) sum += a[i] * b[i];
+  return sum;
+}
+
+static void axpyScalar(double alpha, const double *x, double *y, int n) {
+  for (int i = 0; i < n; ++i) y[i] += alpha * x[i];
+}
+
+static void scaleScalar(double *a, double s, int n) {
+  for (int i = 0; i < n; ++i) a[i] *= s;
+}
+
+static double minScalar(double m, const double *a, int n) {
+  for (int i = 0; i < n; ++i) if (a[i] < m) m = a[i];
+  return m;
+}
+
+static double maxScalar(double m, const double *a, int n) {
+  for (int i = 0; i < n; ++i) if (a[i] > m) m = a[i];
+  return m;
+}
+
+#if defined(__SSE2__)
+// SSE2 kernels, two lanes.
+
+static double hsum128(__m128d v) {
+  return _mm_cvtsd_f64(_mm_add_sd(v, _mm_unpackhi_pd(v, v)));
+}
+
+static double sumSse2(const double *a, int n) {
+  __m128d acc0 = _mm_setzero_pd(), acc1 = _mm_setzero_pd();
+  int i = 0;
+  for (; i + 4 <= n; i += 4) {
+    acc0 = _mm_add_pd(acc0, _mm_loadu_pd(a + i));
+    acc1 = _mm_add_pd(acc1, _mm_loadu_pd(a + i + 2));
+  }
+  return hsum128(_mm_add_pd(acc0, acc1)) + sumScalar(a + i, n - i);
+}
+
+static double dotSse2(const double *a, const double *b, int n) {
+  __m128d acc0 = _mm_setzero_pd(), acc1 = _mm_setzero_pd();
+  int i = 0;
+  for (; i + 4 <= n; i += 4) {
+    acc0 = _mm_add_pd(acc0, _mm_mul_pd(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i)));
+    acc1 = _mm_add_pd(acc1, _mm_mul_pd(_mm_loadu_pd(a + i + 2), _mm_loadu_pd(b + i + 2)));
+  }
+  return hsum128(_mm_add_pd(acc0, acc1)) + dotScalar(a + i, b + i, n - i);
+}
+
+static void axpySse2(double alpha, const double *x, double *y, int n) {
+  __m128d va = _mm_set1_pd(alpha);
+  int i = 0;
+  for (; i + 2 <= n; i += 2)
+    _mm_storeu_pd(y + i, _mm_add_pd(_mm_loadu_pd(y + i), _mm_mul_pd(va, _mm_loadu_pd(x + i))));
+  axpyScalar(alpha, x + i, y + i, n - i);
+}
+
+static void scaleSse2(double *a, double s, int n) {
+  __m128d vs = _mm_set1_pd(s);
+  int i = 0;
+  for (; i + 2 <= n; i += 2)
+    _mm_storeu_pd(a + i, _mm_mul_pd(_mm_loadu_pd(a + i), vs));
+  scaleScalar(a + i, s, n - i);
+}
+
+static double minSse2(const double *a, int n) {
+  __m128d m = _mm_set1_pd(a[0]);
+  int i = 0;
+  for (; i + 2 <= n; i += 2) m = _mm_min_pd(_mm_loadu_pd(a + i), m);
+  double lanes[2];
+  _mm_storeu_pd(lanes, m);
+  return minScalar(lanes[0] < lanes[1] ? lanes[0] : lanes[1], a + i, n - i);
+}
+
+static double maxSse2(const double *a, int n) {
+  __m128d m = _mm_set1_pd(a[0]);
+  int i = 0;
+  for (; i + 2 <= n; i += 2) m = _mm_max_pd(_mm_loadu_pd(a + i), m);
+  double lanes[2];
+  _mm_storeu_pd(lanes, m);
+  return maxScalar(lanes[0] > lanes[1] ? lanes[0] : lanes[1], a + i, n - i);
+}
+#endif
+
+#if KLOX_F64_X86
+// AVX2 kernels, four lanes.  These are compiled for AVX2 regardless of the
+// build's target and only selected when the CPU reports support.
+//NOTE: FMA is deliberately not used for axpy so that its per-element results
+// match those of the other kernels exactly.
+
+#define KLOX_AVX2 __attribute__((target("avx2")))
+
+KLOX_AVX2 static double hsum256(__m256d v) {
+  __m128d lo = _mm256_castpd256_pd128(v);
+  __m128d hi = _mm256_extractf128_pd(v, 1);
+  lo = _mm_add_pd(lo, hi);
+  return _mm_cvtsd_f64(_mm_add_sd(lo, _mm_unpackhi_pd(lo, lo)));
+}
+
+KLOX_AVX2 static double sumAvx2(const double *a, int n) {
+  __m256d acc0 = _mm256_setzero_pd(), acc1 = _mm256_setzero_pd();
+  int i = 0;
+  for (; i + 8 <= n; i += 8) {
+    acc0 = _mm256_add_pd(acc0, _mm256_loadu_pd(a + i));
+    acc1 = _mm256_add_pd(acc1, _mm256_loadu_pd(a + i + 4));
+  }
+  return hsum256(_mm256_add_pd(acc0, acc1)) + sumScalar(a + i, n - i);
+}
+
+KLOX_AVX2 static double dotAvx2(const double *a, const double *b, int n) {
+  __m256d acc0 = _mm256_setzero_pd(), acc1 = _mm256_setzero_pd();
+  int i = 0;
+  for (; i + 8 <= n; i += 8) {
+    acc0 = _mm256_add_pd(acc0, _mm256_mul_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i)));
+    acc1 = _mm256_add_pd(acc1, _mm256_mul_pd(_mm256_loadu_pd(a + i + 4), _mm256_loadu_pd(b + i + 4)));
+  }
+  return hsum256(_mm256_add_pd(acc0, acc1)) + dotScalar(a + i, b + i, n - i);
+}
+
+KLOX_AVX2 static void axpyAvx2(double alpha, const double *x, double *y, int n) {
+  __m256d va = _mm256_set1_pd(alpha);
+  int i = 0;
+  for (; i + 4 <= n; i += 4)
+    _mm256_storeu_pd(y + i, _mm256_add_pd(_mm256_loadu_pd(y + i), _mm256_mul_pd(va, _mm256_loadu_pd(x + i))));
+  axpyScalar(alpha, x + i, y + i, n - i);
+}
+
+KLOX_AVX2 static void scaleAvx2(double *a, double s, int n) {
+  __m256d vs = _mm256_set1_pd(s);
+  int i = 0;
+  for (; i + 4 <= n; i += 4)
+    _mm256_storeu_pd(a + i, _mm256_mul_pd(_mm256_loadu_pd(a + i), vs));
+  scaleScalar(a + i, s, n - i);
+}
+
+KLOX_AVX2 static double minAvx2(const double *a, int n) {
+  __m256d m = _mm256_set1_pd(a[0]);
+  int i = 0;
+  for (; i + 4 <= n; i += 4) m = _mm256_min_pd(_mm256_loadu_pd(a + i), m);
+  double lanes[4];
+  _mm256_storeu_pd(lanes, m);
+  return minScalar(minScalar(lanes[0], lanes + 1, 3), a + i, n - i);
+}
+
+KLOX_AVX2 static double maxAvx2(const double *a, int n) {
+  __m256d m = _mm256_set1_pd(a[0]);
+  int i = 0;
+  for (; i + 4 <= n; i += 4) m = _mm256_max_pd(_mm256_loadu_pd(a + i), m);
+  double lanes[4];
+  _mm256_storeu_pd(lanes, m);
+  return maxScalar(maxScalar(lanes[0], lanes + 1, 3), a + i, n - i);
+}
+#endif
+
+#if KLOX_F64_X86
+#define F64_DISPATCH_AVX2(call) do { if (haveAvx2()) return call; } while (0)
+#else
+#define F64_DISPATCH_AVX2(call) do { } while (0)
+#endif
+
+double f64ArraySum(const double *a, int n) {
+  F64_DISPATCH_AVX2(sumAvx2(a, n));
+#if defined(__SSE2__)
+  return sumSse2(a, n);
+#else
+  return sumScalar(a, n);
+#endif
+}
+
+double f64ArrayDot(const double *a, const double *b, int n) {
+  F64_DISPATCH_AVX2(dotAvx2(a, b, n));
+#if defined(__SSE2__)
+  return dotSse2(a, b, n);
+#else
+  return dotScalar(a, b, n);
+#endif
+}
+
+void f64ArrayAxpy(double alpha, const double *x, double *y, int n) {
+  F64_DISPATCH_AVX2(axpyAvx2(alpha, x, y, n));
+#if defined(__SSE2__)
+  axpySse2(alpha, x, y, n);
+#else
+  axpyScalar(alpha, x, y, n);
+#endif
+}
+
+void f64ArrayScale(double *a, double s, int n) {
+  F64_DISPATCH_AVX2(scaleAvx2(a, s, n));
+#if defined(__SSE2__)
+  scaleSse2(a, s, n);
+#else
+  scaleScalar(a, s, n);
+#endif
+}
+
+// Skips the leading NaNs of a, returning how many there were.
+//NOTE: The min/max kernels rely on this to start from a non-NaN value.  They
+// then skip any later NaNs, as both the comparisons of the scalar kernels and
+// the (v, m) operand order of the vector ones keep m when v is NaN.
+static int skipLeadingNans(const double *a, int n) {
+  int i = 0;
+  while (i < n && isnan(a[i])) ++i;
+  return i;
+}
+
+double f64ArrayMin(const double *a, int n) {
+  assert(n > 0);
+  int skipped = skipLeadingNans(a, n);
+  if (skipped == n) return a[0];
+  a += skipped;
+  n -= skipped;
+  F64_DISPATCH_AVX2(minAvx2(a, n));
+#if defined(__SSE2__)
+  return minSse2(a, n);
+#else
+  return minScalar(a[0], a + 1, n - 1);
+#endif
+}
+
+double f64ArrayMax(const double *a, int n) {
+  assert(n > 0);
+  int skipped = skipLeadingNans(a, n);
+  if (skipped == n) return a[0];
+  a += skipped;
+  n -= skipped;
+  F64_DISPATCH_AVX2(maxAvx2(a, n));
+#if defined(__SSE2__)
+  return maxSse2(a, n);
+#else
+  return maxScalar(a[0], a + 1, n - 1);
+#endif
+}
+
+void f64ArraySort(double *a, int n) {
+  //NOTE: NaNs are ordered after all other values, keeping the comparison a
+  // strict weak ordering as std::sort() requires.
+  std::sort(a, a + n, [](double x, double y) {
+    return !isnan(x) && (isnan(y) || x < y);
+  });
+}
@@ -0,0 +1,20 @@
+#ifndef klox_f64array_h
+#define klox_f64array_h
+
+#include "common.h"
+
+// Kernels over contiguous unboxed doubles, as held by an ObjF64Array.  Each is
+// vectorized with AVX2 where the running CPU supports it, otherwise with SSE2
+// where compiled for it, otherwise scalar.
+//NOTE: sum and dot accumulate in several lanes at once, so their result may
+// differ in the last bits from a strictly sequential summation.
+
+double f64ArraySum(const double *a, int n);
+double f64ArrayDot(const double *a, const double *b, int n);
+void f64ArrayAxpy(double alpha, const double *x, double *y, int n);  //y = alpha*x + y
+void f64ArrayScale(double *a, double s, int n);  //a = s*a
+double f64ArrayMin(const double *a, int n);  //n > 0; NaNs skipped, NaN if all are
+double f64ArrayMax(const double *a, int n);  //n > 0; NaNs skipped, NaN if all are
+void f64ArraySort(double *a, int n);  //NaNs last
+
+#endif
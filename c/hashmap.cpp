@@ -0,0 +1,219 @@
+#include <assert.h>
+#include <string.h>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "hashmap.h"
+#include "memory.h"
+#include "object.h"
+#include "value.h"
+
+// Maximum load (live entries plus tombstones), as a fraction of capacity.
+#define HASHMAP_MAX_LOAD_NUM 7
+#define HASHMAP_MAX_LOAD_DEN 8
+
+static inline uint64_t hashValue(Value key) {
+  uint64_t x = key.val;
+
+  // 0 and -0 are equal as per valuesEqual(), and so must hash alike.
+  if (IS_NUMBER(key) && AS_NUMBER(key) == 0) x = 0;
+
+  // splitmix64 finalizer.  Strings are interned and other objects compare by
+  // identity, so hashing the raw Value is sufficient for all key types.
+  x ^= x >> 30;
+  x *= 0xbf58476d1ce4e5b9ULL;
+  x ^= x >> 27;
+  x *= 0x94d049bb133111ebULL;
+  x ^= x >> 31;
+  return x;
+}
+
+static inline uint8_t hashTag(uint64_t hash) {
+  return (uint8_t)(hash & 0x7F);
+}
+
+static inline size_t hashGroup(uint64_t hash) {
+  return (size_t)(hash >> 7);
+}
+
+// Bitmask of the slots of the group at 'ctrl' whose control byte is 'c'.
+static inline uint32_t groupMatch(const uint8_t *ctrl, uint8_t c) {
+#if defined(__SSE2__)
+  __m128i group = _mm_loadu_si128((const __m128i *)ctrl);
+  return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8((char)c)));
+#else
+  uint32_t mask = 0;
+  for (int i = 0; i < HASHMAP_GROUP_WIDTH; ++i) {
+    if (ctrl[i] == c) mask |= (1u << i);
+  }
+  return mask;
+#endif
+}
+
+// Bitmask of the slots of the group at 'ctrl' which are empty or deleted.
+static inline uint32_t groupMatchAvailable(const uint8_t *ctrl) {
+#if defined(__SSE2__)
+  // Exactly the empty and deleted control bytes have their high bit set.
+  __m128i group = _mm_loadu_si128((const __m128i *)ctrl);
+  return (uint32_t)_mm_movemask_epi8(group);
+#else
+  uint32_t mask = 0;
+  for (int i = 0; i < HASHMAP_GROUP_WIDTH; ++i) {
+    if (!hashMapCtrlIsFull(ctrl[i])) mask |= (1u << i);
+  }
+  return mask;
+#endif
+}
+
+// Returns the slot holding 'key', or -1 if it is absent.
+//NOTE: Groups are probed triangularly, which visits every group when the group
+// count is a power of 2.  The load limit guarantees some group holds an empty
+// slot, so the probe always terminates.
+static int findSlot(const HashMapEntry *entries, int capacity, Value key, uint64_t hash) {
+  const uint8_t *ctrl = hashMapCtrl(entries, capacity);
+  size_t groupMask = capacity / HASHMAP_GROUP_WIDTH - 1;
+  size_t group = hashGroup(hash) & groupMask;
+  uint8_t tag = hashTag(hash);
+
+  for (size_t probe = 1; ; ++probe) {
+    const uint8_t *groupCtrl = ctrl + group * HASHMAP_GROUP_WIDTH;
+
+    for (uint32_t candidates = groupMatch(groupCtrl, tag); candidates != 0; candidates &= candidates - 1) {
+      int slot = (int)(group * HASHMAP_GROUP_WIDTH) + __builtin_ctz(candidates);
+      if (valuesEqual(entries[slot].key, key)) return slot;
+    }
+
+    if (groupMatch(groupCtrl, HASHMAP_CTRL_EMPTY) != 0) return -1;
+
+    group = (group + probe) & groupMask;
+  }
+}
+
+// Returns the first empty or deleted slot along the probe sequence of 'hash'.
+static int findInsertSlot(const HashMapEntry *entries, int capacity, uint64_t hash) {
+  const uint8_t *ctrl = hashMapCtrl(entries, capacity);
+  size_t groupMask = capacity / HASHMAP_GROUP_WIDTH - 1;
+  size_t group = hashGroup(hash) & groupMask;
+
+  for (size_t probe = 1; ; ++probe) {
+    uint32_t available = groupMatchAvailable(ctrl + group * HASHMAP_GROUP_WIDTH);
+    if (available != 0)
+      return (int)(group * HASHMAP_GROUP_WIDTH) + __builtin_ctz(available);
+
+    group = (group + probe) & groupMask;
+  }
+}
+
+// Moves all live entries into a fresh table of 'newCapacity' slots, dropping
+// any tombstones.
+static void hashMapResize(OID<ObjHashMap> map, int newCapacity) {
+  PIN_SCOPE;
+  CBO<HashMapEntry> newEntriesCBO = ALLOCATE(HashMapEntry, hashMapStorageCount(newCapacity));
+
+  //NOTE: A fresh table is built rather than rehashing in place, as the
+  // existing one may belong to a B or C layer of this map which must not be
+  // disturbed.
+  HashMapEntry *newEntries = newEntriesCBO.mlp().mp();  //cb-resize-safe (no allocations in lifetime)
+  uint8_t *newCtrl = hashMapCtrlMutable(newEntries, newCapacity);
+  memset(newCtrl, HASHMAP_CTRL_EMPTY, newCapacity);
+
+  const ObjHashMap *cmap = map.clip().cp();  //re-derive, allocation may have provoked a GC
+  int oldCapacity = cmap->capacity;
+  if (oldCapacity > 0) {
+    const HashMapEntry *oldEntries = cmap->entries.clp().cp();
+    const uint8_t *oldCtrl = hashMapCtrl(oldEntries, oldCapacity);
+
+    for (int i = 0; i < oldCapacity; ++i) {
+      if (!hashMapCtrlIsFull(oldCtrl[i])) continue;
+
+      int slot = findInsertSlot(newEntries, newCapacity, hashValue(oldEntries[i].key));
+      newCtrl[slot] = oldCtrl[i];
+      newEntries[slot] = oldEntries[i];
+    }
+  }
+
+  ObjHashMap *mmap = map.mlip().mp();
+
+  //NOTE: Because this resize is done to a map already present in the
+  // objtable, we must manually inform the objtable of this independent
+  // mutation of external size.  This is only done once the mutable layer has
+  // been derived, as deriving it may provoke a GC, which would freeze the
+  // adjusted A layer without the map in it.
+  objtable_external_size_adjust_A(&thread_objtable,
+                                  ((ssize_t)hashMapStorageCount(newCapacity) - (ssize_t)hashMapStorageCount(oldCapacity)) * sizeof(HashMapEntry));
+  mmap->capacity = newCapacity;
+  mmap->tombstones = 0;
+  mmap->entries = newEntriesCBO;
+}
+
+bool hashMapGet(OID<ObjHashMap> map, Value key, Value *value) {
+  const ObjHashMap *cmap = map.clip().cp();
+  if (cmap->count == 0) return false;
+
+  const HashMapEntry *entries = cmap->entries.clp().cp();
+  int slot = findSlot(entries, cmap->capacity, key, hashValue(key));
+  if (slot < 0) return false;
+
+  *value = entries[slot].value;
+  return true;
+}
+
+void hashMapSet(OID<ObjHashMap> map, Value key, Value value) {
+  PIN_SCOPE;
+  uint64_t hash = hashValue(key);
+  const ObjHashMap *cmap = map.clip().cp();
+
+  if (cmap->count > 0) {
+    int slot = findSlot(cmap->entries.clp().cp(), cmap->capacity, key, hash);
+    if (slot >= 0) {
+      //NOTE: mlip() will first derive a mutable A-layer copy of the map if it
+      // presently resides in B or C (copy-on-write).
+      map.mlip().mp()->entries.mlp().mp()[slot].value = value;
+      return;
+    }
+  }
+
+  if ((cmap->count + cmap->tombstones + 1) * HASHMAP_MAX_LOAD_DEN > cmap->capacity * HASHMAP_MAX_LOAD_NUM) {
+    // Only grow when live entries demand it; otherwise rehashing at the same
+    // capacity suffices to reclaim the tombstones.
+    int newCapacity = cmap->capacity;
+    if (newCapacity == 0)
+      newCapacity = HASHMAP_GROUP_WIDTH;
+    else if ((cmap->count + 1) * 2 * HASHMAP_MAX_LOAD_DEN > cmap->capacity * HASHMAP_MAX_LOAD_NUM)
+      newCapacity *= 2;
+    hashMapResize(map, newCapacity);
+  }
+
+  ObjHashMap *mmap = map.mlip().mp();
+  HashMapEntry *entries = mmap->entries.mlp().mp();  //cb-resize-safe (no allocations in lifetime)
+  uint8_t *ctrl = hashMapCtrlMutable(entries, mmap->capacity);
+  int slot = findInsertSlot(entries, mmap->capacity, hash);
+
+  if (ctrl[slot] == HASHMAP_CTRL_DELETED) mmap->tombstones--;
+  ctrl[slot] = hashTag(hash);
+  entries[slot].key = key;
+  entries[slot].value = value;
+  mmap->count++;
+}
+
+bool hashMapDelete(OID<ObjHashMap> map, Value key) {
+  const ObjHashMap *cmap = map.clip().cp();
+  if (cmap->count == 0) return false;
+
+  int slot = findSlot(cmap->entries.clp().cp(), cmap->capacity, key, hashValue(key));
+  if (slot < 0) return false;
+
+  ObjHashMap *mmap = map.mlip().mp();
+  HashMapEntry *entries = mmap->entries.mlp().mp();  //cb-resize-safe (no allocations in lifetime)
+
+  //NOTE: The slot must remain distinguishable from an empty one, lest probes
+  // for keys placed beyond it stop short.  The entry is cleared so that the
+  // collector will no longer trace it.
+  hashMapCtrlMutable(entries, mmap->capacity)[slot] = HASHMAP_CTRL_DELETED;
+  entries[slot].key = NIL_VAL;
+  entries[slot].value = NIL_VAL;
+  mmap->count--;
+  mmap->tombstones++;
+  return true;
+}
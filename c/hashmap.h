@@ -0,0 +1,40 @@
+#ifndef klox_hashmap_h
+#define klox_hashmap_h
+
+#include "cb_integration.h"
+#include "common.h"
+#include "object.h"
+#include "value.h"
+
+// Slots are probed a group at a time.  The control bytes of a group are
+// matched against the sought hash tag all at once (via SSE2 where available).
+#define HASHMAP_GROUP_WIDTH 16
+
+// Control byte values.  A full slot's control byte instead holds the low 7
+// bits of its key's hash.
+#define HASHMAP_CTRL_EMPTY   ((uint8_t)0x80)
+#define HASHMAP_CTRL_DELETED ((uint8_t)0xFE)
+
+// The number of HashMapEntry units backing a table of the given capacity,
+// including the trailing control bytes.
+static inline size_t hashMapStorageCount(int capacity) {
+  return capacity + (capacity * sizeof(uint8_t) + sizeof(HashMapEntry) - 1) / sizeof(HashMapEntry);
+}
+
+static inline const uint8_t *hashMapCtrl(const HashMapEntry *entries, int capacity) {
+  return (const uint8_t *)(entries + capacity);
+}
+
+static inline uint8_t *hashMapCtrlMutable(HashMapEntry *entries, int capacity) {
+  return (uint8_t *)(entries + capacity);
+}
+
+static inline bool hashMapCtrlIsFull(uint8_t ctrl) {
+  return (ctrl & 0x80) == 0;
+}
+
+bool hashMapGet(OID<ObjHashMap> map, Value key, Value *value);
+void hashMapSet(OID<ObjHashMap> map, Value key, Value value);
+bool hashMapDelete(OID<ObjHashMap> map, Value key);
+
+#endif
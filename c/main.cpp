@@ -6,6 +6,7 @@
 #include "common.h"
 #include "chunk.h"
 #include "debug.h"
+#include "ring.h"
 #include "vm.h"
 
 static void repl() {
@@ -26,6 +27,7 @@ static bool needs_gc_deinit = false;
 
 void
 exitWithError(int exitCode) {
+  ring_save_hint();
   if (needs_gc_deinit)
     gc_deinit();
   exit(exitCode);
@@ -89,18 +91,17 @@ int main(int argc, const char* argv[]) {
   }
 
   /* Create thread-local continuous buffer. */
-  uintmax_t ring_size = 1 << 12;  //Start very small by default, 1 page = 4096 bytes
-  if (getenv("KLOX_RING_SIZE")) sscanf(getenv("KLOX_RING_SIZE"), "%ju", &ring_size);
-  cb_params.ring_size = (size_t)ring_size;
+  cb_params.ring_size = ring_initial_size(argc == 2 ? argv[1] : NULL);
   cb_params.mmap_flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE;
   cb_params.flags |= CB_PARAMS_F_MLOCK;
   cb_params.on_preresize = &klox_on_cb_preresize;
   cb_params.on_resize = &klox_on_cb_resize;
-  thread_cb = cb_create(&cb_params, sizeof(cb_params));
+  thread_cb = ring_create(&cb_params);
   if (!thread_cb) {
     fprintf(stderr, "Could not create continuous buffer. \n");
     return EXIT_FAILURE;
   }
+  ring_reclaim_init();
   thread_cb_at_immed_param.ring_start = cb_ring_start(thread_cb);
   thread_cb_at_immed_param.ring_mask = cb_ring_mask(thread_cb);
 
@@ -138,6 +139,7 @@ int main(int argc, const char* argv[]) {
     exitWithError(64);
   }
 
+  ring_save_hint();
   freeVM();
   gc_deinit();
   return 0;
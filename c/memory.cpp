@@ -8,7 +8,9 @@
 #include "cb_integration.h"
 #include "common.h"
 #include "compiler.h"
+#include "hashmap.h"
 #include "memory.h"
+#include "ring.h"
 #include "vm.h"
 
 #ifdef DEBUG_TRACE_GC
@@ -17,6 +19,7 @@
 #endif
 
 #define GC_HEAP_GROW_FACTOR 2
+#define GC_OBJTABLE_RESERVE_HEADROOM 2
 
 #if !KLOX_SYNC_GC
 #if PROVOKE_RESIZE_DURING_GC
@@ -26,6 +29,22 @@ static bool resize_during_gc_already_provoked = false;
 
 cb_offset_t last_point_of_gc = 0;
 
+//NOTE: The fraction of its worst-case size which the last objtable
+// consolidation actually used.  Deduplication and unreachable objects make this
+// typically far below 1.0, so the next consolidation's region is reserved from
+// it (with headroom) instead of from the worst case.  The last submitted
+// request is kept so that it can be resubmitted should that fall short.
+static double objtable_consolidation_fill = 1.0;
+static struct gc_request gc_submitted_request;
+
+static size_t
+objtableReserveSize(size_t worst_size) {
+  size_t size = (size_t)((double)worst_size * objtable_consolidation_fill * GC_OBJTABLE_RESERVE_HEADROOM)
+                + objtable_consolidation_margin();
+  return (size < worst_size ? size : worst_size);
+}
+
+#ifndef NDEBUG
 size_t
 alloc_size_get(const char *mem) {
   size_t size;
@@ -61,6 +80,7 @@ static void
 alloc_is_object_set(char *mem, bool is_object) {
   memcpy(mem - (2 * sizeof(size_t) + sizeof(bool)) , &is_object, sizeof(bool));
 }
+#endif  //NDEBUG
 
 static inline void
 clobber_mem(void *p, size_t len) {
@@ -108,10 +128,15 @@ cb_offset_t reallocate_within(struct cb **cb, struct cb_region *region, cb_offse
       clobber_mem(((char *)cb_at(*cb, previous)) + newSize, oldSize - newSize);
     return previous;
   } else {
+#ifndef NDEBUG
     size_t header_size = sizeof(size_t)   /* size field */
                          + sizeof(size_t) /* alignment field */
                          + sizeof(bool);  /* isObject field */
     size_t needed_contiguous_size = header_size + (alignment - 1) + newSize;
+#else
+    //NOTE: Without a header, cb_region_memalign() alone provides the alignment.
+    size_t needed_contiguous_size = newSize;
+#endif
     cb_offset_t new_offset;
     int ret;
 
@@ -124,12 +149,17 @@ cb_offset_t reallocate_within(struct cb **cb, struct cb_region *region, cb_offse
                              needed_contiguous_size);
     assert(ret == CB_SUCCESS);
 
+    char *mem;
+#ifndef NDEBUG
     new_offset = cb_offset_aligned_gte(new_offset + header_size, alignment);
 
-    char *mem = (char *)cb_at(*cb, new_offset);
+    mem = (char *)cb_at(*cb, new_offset);
     alloc_size_set(mem, newSize);
     alloc_alignment_set(mem, alignment);
     alloc_is_object_set(mem, isObject);
+#else
+    mem = (char *)cb_at(*cb, new_offset);
+#endif
 
     //Q: Should we keep the ObjID the same over reallocation?
     //A: No, changing it adheres to the earlier API which expects a shift of
@@ -284,18 +314,13 @@ static void grayFieldsStructmap(const FieldsSM *sm) {
   assert(ret == 0);
 }
 
-void grayObjectLeaves(const OID<Obj> objectOID) {
-  const Obj *object;
-  bool found_in_b;
+static void grayObjectLeavesAt(const OID<Obj> objectOID, cb_offset_t objectOffset) {
+  //NOTE: we're in GC thread and therefore this is not RCBP (as GC must not cause resize).
+  const Obj *object = (const Obj *)cb_at(thread_cb, objectOffset);
 
   //There should never be any A region contents during this call.
   assert(!objectOID.clipA().cp());
 
-  //Find the Obj whose leaves are to be darkened in either the B or C region.
-  object = objectOID.clipB().cp();  //NOTE: we're in GC thread and therefore this is not RCBP (as GC must not cause resize).
-  found_in_b = !!object;
-  if (!found_in_b) object = objectOID.clipC().cp();
-
 #ifdef DEBUG_TRACE_GC
   KLOX_TRACE("id: #%ju, obj: ", (uintmax_t)objectOID.id().id);
   KLOX_TRACE_ONLY(printValue(OBJ_VAL(objectOID.id()), false));
@@ -320,12 +345,12 @@ void grayObjectLeaves(const OID<Obj> objectOID) {
       // collector only deals with regions B and C.  If retrieval of the
       // objectOID has given us a B region ObjClass layer, then also gray any
       // methods of any backing C region ObjClass layer.
-      if (found_in_b) {
-        const ObjClass* klass_C = (const ObjClass*)objectOID.clipC().cp();
-        if (klass_C) {
-          KLOX_TRACE("found backing class for #%ju\n", objectOID.id().id);
-          grayMethodsStructmap(&(klass_C->methods_sm));
-        }
+      // (This is the case whenever C holds a layer other than this one.)
+      cb_offset_t cOffset = objectOID.co_C();
+      if (cOffset != CB_NULL && cOffset != objectOffset) {
+        const ObjClass* klass_C = (const ObjClass*)cb_at(thread_cb, cOffset);
+        KLOX_TRACE("found backing class for #%ju\n", objectOID.id().id);
+        grayMethodsStructmap(&(klass_C->methods_sm));
       }
       break;
     }
@@ -348,6 +373,20 @@ void grayObjectLeaves(const OID<Obj> objectOID) {
       break;
     }
 
+    case OBJ_HASHMAP: {
+      const ObjHashMap* map = (const ObjHashMap*)object;
+      if (map->capacity > 0) {
+        const HashMapEntry* entries = map->entries.clp().cp();
+        const uint8_t* ctrl = hashMapCtrl(entries, map->capacity);
+        for (int i = 0; i < map->capacity; i++) {
+          if (!hashMapCtrlIsFull(ctrl[i])) continue;
+          grayValue(entries[i].key);
+          grayValue(entries[i].value);
+        }
+      }
+      break;
+    }
+
     case OBJ_INSTANCE: {
       const ObjInstance* instance = (const ObjInstance*)object;
       grayObject(instance->klass.id());
@@ -357,20 +396,34 @@ void grayObjectLeaves(const OID<Obj> objectOID) {
       // collector only deals with regions B and C.  If retrieval of the
       // objectOID has given us a B region ObjInstance layer, then also gray any
       // fields of any backing C region ObjInstance layer.
-      if (found_in_b) {
-        const ObjInstance* instance_C = (const ObjInstance*)objectOID.clipC().cp();
-        if (instance_C) {
-          KLOX_TRACE("found backing instance for #%ju\n", objectOID.id().id);
-          grayFieldsStructmap(&(instance_C->fields_sm));
-        }
+      // (This is the case whenever C holds a layer other than this one.)
+      cb_offset_t cOffset = objectOID.co_C();
+      if (cOffset != CB_NULL && cOffset != objectOffset) {
+        const ObjInstance* instance_C = (const ObjInstance*)cb_at(thread_cb, cOffset);
+        KLOX_TRACE("found backing instance for #%ju\n", objectOID.id().id);
+        grayFieldsStructmap(&(instance_C->fields_sm));
       }
       break;
     }
 
+    case OBJ_LIST: {
+      const ObjList* list = (const ObjList*)object;
+      const Value* values = list->values.clp().cp();
+      for (int i = 0; i < list->count; i++) {
+        grayValue(values[i]);
+      }
+      break;
+    }
+
+    case OBJ_MAP:
+      grayBst(((const ObjMap*)object)->root);
+      break;
+
     case OBJ_UPVALUE:
       grayValue(((const ObjUpvalue*)object)->closed);
       break;
 
+    case OBJ_F64ARRAY:
     case OBJ_NATIVE:
     case OBJ_STRING:
       // No references.
@@ -378,6 +431,28 @@ void grayObjectLeaves(const OID<Obj> objectOID) {
   }
 }
 
+void grayObjectLeaves(const OID<Obj> *objectOIDs, unsigned int n) {
+  ObjID ids[GRAY_LEAVES_BATCH_MAX] = {};
+  cb_offset_t offsets[GRAY_LEAVES_BATCH_MAX];
+
+  assert(n <= GRAY_LEAVES_BATCH_MAX);
+
+  //NOTE: The ids are copied out first, as graying the leaves pushes onto the
+  // same gray stack from which objectOIDs may have been popped.
+  for (unsigned int i = 0; i < n; ++i) ids[i] = objectOIDs[i].id();
+
+  //Find the Objs whose leaves are to be darkened in either the B or C region,
+  // resolving them all at once so that their lookups overlap, and start
+  // bringing in each Obj before darkening the leaves of any.
+  objtable_lookup_batch(&thread_objtable, ids, offsets, n);
+  for (unsigned int i = 0; i < n; ++i) {
+    assert(offsets[i] != CB_NULL);
+    __builtin_prefetch(cb_at(thread_cb, offsets[i]));
+  }
+
+  for (unsigned int i = 0; i < n; ++i) grayObjectLeavesAt(ids[i], offsets[i]);
+}
+
 static int
 dedupe_entry_render(cb_offset_t           *dest_offset,
                     struct cb            **cb,
@@ -459,6 +534,19 @@ static void freeObject(OID<Obj> object) {
   objtable_invalidate(&thread_objtable, object.id());
 }
 
+struct copy_entry_closure
+{
+  struct cb        **dest_cb;
+  struct cb_region  *dest_region;
+  cb_offset_t       *dest_bst;
+  DEBUG_ONLY(size_t  last_bst_size);
+};
+
+static int
+copy_entry_to_bst(const struct cb_term *key_term,
+                  const struct cb_term *value_term,
+                  void                 *closure);
+
 //NOTE: This function may be called from both the main execution thread, or from
 // the GC thread.  In the latter case, the RCBP's are not a problem because:
 // 1) The linked list on which they will be held will be thread-local to the
@@ -531,6 +619,22 @@ cb_offset_t deriveMutableObjectLayer(struct cb **cb, struct cb_region *region, O
       break;
     }
 
+    case OBJ_F64ARRAY: {
+      destCBO = reallocate_within(cb, region, CB_NULL, 0, sizeof(ObjF64Array), cb_alignof(ObjF64Array), true, suppress_gc);
+      RCBP<const ObjF64Array> srcR = srcOID.crip(*cb);
+      CBO<double> newValues = GROW_ARRAY_NOGC_WITHIN(cb, region, CB_NULL, double, 0, srcR.cp()->count);
+      const ObjF64Array *src  = srcR.cp();  //cb-resize-safe (no allocations in lifetime)
+      ObjF64Array       *dest = (ObjF64Array *)destCBO.mrp(*cb).mp();  //cb-resize-safe (no allocations in lifetime)
+
+      dest->obj    = src->obj;
+      dest->count  = src->count;
+      dest->values = newValues;
+      if (src->count > 0)
+        memcpy(dest->values.mrp(*cb).mp(), src->values.crp(*cb).cp(), src->count * sizeof(double));
+
+      break;
+    }
+
     case OBJ_FUNCTION: {
       destCBO = reallocate_within(cb, region, CB_NULL, 0, sizeof(ObjFunction), cb_alignof(ObjFunction), true, suppress_gc);
       RCBP<const ObjFunction> srcR = srcOID.crip(*cb);
@@ -558,6 +662,27 @@ cb_offset_t deriveMutableObjectLayer(struct cb **cb, struct cb_region *region, O
       break;
     }
 
+    case OBJ_HASHMAP: {
+      destCBO = reallocate_within(cb, region, CB_NULL, 0, sizeof(ObjHashMap), cb_alignof(ObjHashMap), true, suppress_gc);
+      RCBP<const ObjHashMap> srcR = srcOID.crip(*cb);
+      size_t storageCount = hashMapStorageCount(srcR.cp()->capacity);
+      CBO<HashMapEntry> newEntries = GROW_ARRAY_NOGC_WITHIN(cb, region, CB_NULL, HashMapEntry, 0, storageCount);
+      const ObjHashMap *src  = srcR.cp();  //cb-resize-safe (no allocations in lifetime)
+      ObjHashMap       *dest = (ObjHashMap *)destCBO.mrp(*cb).mp();  //cb-resize-safe (no allocations in lifetime)
+
+      dest->obj        = src->obj;
+      dest->count      = src->count;
+      dest->tombstones = src->tombstones;
+      dest->capacity   = src->capacity;
+      dest->entries    = newEntries;
+      //NOTE: The slots and control bytes share one allocation, so the table is
+      // carried over whole without rehashing.
+      if (src->capacity > 0)
+        memcpy(dest->entries.mrp(*cb).mp(), src->entries.crp(*cb).cp(), storageCount * sizeof(HashMapEntry));
+
+      break;
+    }
+
     case OBJ_INSTANCE: {
       destCBO = reallocate_within(cb, region, CB_NULL, 0, sizeof(ObjInstance), cb_alignof(ObjInstance), true, suppress_gc);
       const ObjInstance *src  = (const ObjInstance *)srcOID.crip(*cb).cp();  //cb-resize-safe (no allocations in lifetime)
@@ -572,6 +697,60 @@ cb_offset_t deriveMutableObjectLayer(struct cb **cb, struct cb_region *region, O
       break;
     }
 
+    case OBJ_LIST: {
+      destCBO = reallocate_within(cb, region, CB_NULL, 0, sizeof(ObjList), cb_alignof(ObjList), true, suppress_gc);
+      RCBP<const ObjList> srcR = srcOID.crip(*cb);
+      CBO<Value> newValues = GROW_ARRAY_NOGC_WITHIN(cb, region, CB_NULL, Value, 0, srcR.cp()->capacity);
+      const ObjList *src  = srcR.cp();  //cb-resize-safe (no allocations in lifetime)
+      ObjList       *dest = (ObjList *)destCBO.mrp(*cb).mp();  //cb-resize-safe (no allocations in lifetime)
+
+      dest->obj      = src->obj;
+      dest->count    = src->count;
+      dest->capacity = src->capacity;
+      dest->values   = newValues;
+      //NOTE: Elements hold no out-of-line state of their own, so the whole
+      // live portion of the array is carried over in one copy.
+      if (src->count > 0)
+        memcpy(dest->values.mrp(*cb).mp(), src->values.crp(*cb).cp(), src->count * sizeof(Value));
+
+      break;
+    }
+
+    case OBJ_MAP: {
+      destCBO = reallocate_within(cb, region, CB_NULL, 0, sizeof(ObjMap), cb_alignof(ObjMap), true, suppress_gc);
+      cb_offset_t newRoot;
+      int ret;
+
+      (void)ret;
+
+      ret = map_bst_init(cb, region, &newRoot);
+      assert(ret == 0);
+
+      //NOTE: Any nodes the source BST shared with other versions of this map
+      // are copied in full, as their memory is about to be reclaimed.
+      struct copy_entry_closure cl = {
+        .dest_cb = cb,
+        .dest_region = region,
+        .dest_bst = &newRoot,
+        DEBUG_ONLY(cl.last_bst_size = cb_bst_size(*cb, newRoot))
+      };
+      ret = cb_bst_traverse(*cb,
+                            ((const ObjMap *)srcOID.crip(*cb).cp())->root,
+                            &copy_entry_to_bst,
+                            &cl);
+      assert(ret == 0);
+
+      const ObjMap *src  = (const ObjMap *)srcOID.crip(*cb).cp();  //cb-resize-safe (no allocations in lifetime)
+      ObjMap       *dest = (ObjMap *)destCBO.mrp(*cb).mp();  //cb-resize-safe (no allocations in lifetime)
+
+      dest->obj   = src->obj;
+      dest->count = src->count;
+      dest->root  = newRoot;
+      dest->floor = destCBO.mo();
+
+      break;
+    }
+
     case OBJ_NATIVE: {
       destCBO = reallocate_within(cb, region, CB_NULL, 0, sizeof(ObjNative), cb_alignof(ObjNative), true, suppress_gc);
       const ObjNative *src  = (const ObjNative *)srcOID.crip(*cb).cp();  //cb-resize-safe (no allocations in lifetime)
@@ -622,14 +801,6 @@ cb_offset_t deriveMutableObjectLayer(struct cb **cb, struct cb_region *region, O
   return destCBO.mo();
 }
 
-struct copy_entry_closure
-{
-  struct cb        **dest_cb;
-  struct cb_region  *dest_region;
-  cb_offset_t       *dest_bst;
-  DEBUG_ONLY(size_t  last_bst_size);
-};
-
 static int
 copy_entry_to_bst(const struct cb_term *key_term,
                   const struct cb_term *value_term,
@@ -802,12 +973,24 @@ void freezeARegions(cb_offset_t new_lower_bound) {
   vm.tristack.cbi = vm.tristack.bbi;
   vm.tristack.bbo = vm.tristack.abo;
   vm.tristack.bbi = vm.tristack.abi;
-  ret = cb_region_memalign(&thread_cb,
-                           &thread_region,
-                           &(vm.tristack.abo),
-                           cb_alignof(Value),
-                           sizeof(Value) * STACK_MAX);
-  assert(ret == CB_SUCCESS);
+  {
+    //NOTE: The new A section is sized to receive the current frame's slots
+    // (which will shortly be made mutable), plus the usual headroom, rather
+    // than for a stack of any depth.  It will grow on demand.
+    unsigned int currentSlotsIndex = (vm.triframes.frameCount > 0
+                                      ? triframes_at(&(vm.triframes), vm.triframes.frameCount - 1)->slotsIndex
+                                      : vm.tristack.stackDepth);
+    unsigned int acapacity = vm.tristack.stackDepth - currentSlotsIndex + FRAME_STACK_HEADROOM;
+    if (acapacity < TRISTACK_MIN_CAPACITY) acapacity = TRISTACK_MIN_CAPACITY;
+
+    ret = cb_region_memalign(&thread_cb,
+                             &thread_region,
+                             &(vm.tristack.abo),
+                             cb_alignof(Value),
+                             sizeof(Value) * acapacity);
+    assert(ret == CB_SUCCESS);
+    vm.tristack.acapacity = acapacity;
+  }
   vm.tristack.abi = vm.tristack.stackDepth;
   assert(vm.tristack.abo >= new_lower_bound);
   tristack_recache(&(vm.tristack), thread_cb);
@@ -823,8 +1006,9 @@ void freezeARegions(cb_offset_t new_lower_bound) {
                            &thread_region,
                            &(vm.triframes.abo),
                            cb_alignof(CallFrame),
-                           sizeof(CallFrame) * FRAMES_MAX);
+                           sizeof(CallFrame) * TRIFRAMES_MIN_CAPACITY);
   assert(ret == CB_SUCCESS);
+  vm.triframes.acapacity = TRIFRAMES_MIN_CAPACITY;
   vm.triframes.abi = vm.triframes.frameCount;
   assert(vm.triframes.abo >= new_lower_bound);
   triframes_recache(&(vm.triframes), thread_cb);
@@ -1087,6 +1271,8 @@ void collectGarbage() {
   long pagesize = sysconf(_SC_PAGESIZE);
   assert(pagesize > 0 && is_power_of_2(pagesize));
 
+  ring_resize_ahead(&thread_cb);
+
   cb_offset_t this_point_of_gc = cb_cursor(thread_cb);
 
   ret = logged_region_create(&thread_cb,
@@ -1184,13 +1370,15 @@ void collectGarbage() {
     assert(cb_offset_cmp(cb_region_start(&(rr.cp()->req.objtable_firstlevel_new_region)), new_lower_bound) >= 0);
 
     // Create region which will be used for the contents (nodes and entries) of the new-B ObjTableLayer's structmap.
+    size_t objtable_worst_size = objtable_consolidation_size(&thread_objtable);
     ret = logged_region_create(&thread_cb,
                                &tmp_region,
                                1,  //objtable_consolidation_size() pessimizes with worst-case alignment, so no need to provide any here.
-                               objtable_consolidation_size(&thread_objtable),
+                               objtableReserveSize(objtable_worst_size),
                                CB_REGION_FINAL);
     assert(ret == 0);
     rr.mp()->req.objtable_new_region = tmp_region;
+    rr.mp()->req.objtable_worst_size = objtable_worst_size;
     assert(cb_offset_cmp(cb_region_start(&(rr.cp()->req.objtable_new_region)), new_lower_bound) >= 0);
 
     // Provide the B and C ObjTableLayers which will be consolidated.
@@ -1277,6 +1465,8 @@ void collectGarbage() {
 
   rr.mp()->req.gc_dest_region_start = gc_start_offset;
   rr.mp()->req.gc_dest_region_end = gc_end_offset;
+  rr.mp()->req.gc_retry_region_start = CB_NULL;
+  rr.mp()->req.gc_retry_region_end = CB_NULL;
 
 #if KLOX_SYNC_GC
   //FIXME: Temporarily disabled now that ObjTable is stored within the CB and the PIN_SCOPE of the compilation phase causes huge CBs to be created.
@@ -1302,12 +1492,20 @@ void collectGarbage() {
   last_point_of_gc = this_point_of_gc;
   thread_cutoff_offset = new_lower_bound;
 
+  gc_submitted_request = rr.cp()->req;
   gc_submit_request(rr.mp());
 
 #if KLOX_SYNC_GC
   {
     struct gc_request_response *rr_returned = gc_await_response();
     assert(rr_returned == rr.cp());
+    if (rr_returned->resp.objtable_overflowed) {
+      KLOX_TRACE("setting gc_last_processed_response to overflowed %p\n", rr_returned);
+      gc_last_processed_response = rr_returned;
+      retryOverflowedGCRequest();
+      rr_returned = gc_await_response();
+      assert(!rr_returned->resp.objtable_overflowed);
+    }
     KLOX_TRACE("received GC response with new_lower_bound:%ju, orig_cb:%p\n", (uintmax_t)rr_returned->req.new_lower_bound, rr_returned->req.orig_cb);
     //FIXME: Temporarily disabled now that ObjTable is stored within the CB and the PIN_SCOPE of the compilation phase causes huge CBs to be created.
     //unmprotect_all(thread_cb);
@@ -1343,6 +1541,61 @@ void collectGarbage() {
 #endif //KLOX_SYNC_GC
 }
 
+void retryOverflowedGCRequest() {
+  cb_offset_t rr_offset;
+  RCBP<struct gc_request_response> rr;
+  struct cb_region tmp_region;
+  int ret;
+
+  (void)ret;
+
+  assert(on_main_thread);
+
+  long pagesize = sysconf(_SC_PAGESIZE);
+  assert(pagesize > 0 && is_power_of_2(pagesize));
+
+  KLOX_TRACE("Retrying GC request with a worst-case objtable region of %zu bytes\n",
+             gc_submitted_request.objtable_worst_size);
+
+  //Only a region reserved short of the worst case can have overflowed.
+  assert(cb_region_end(&(gc_submitted_request.objtable_new_region)) - cb_region_start(&(gc_submitted_request.objtable_new_region))
+         < gc_submitted_request.objtable_worst_size);
+
+  //NOTE: See collectGarbage() regarding the loop.
+  do {
+    ret = cb_memalign(&thread_cb, &rr_offset, pagesize, sizeof(struct gc_request_response));  //pagesize alignment needed for mprotect().
+    assert(ret == 0);
+    rr = rr_offset;
+  } while (rr.cp() == gc_last_processed_response);
+
+  //NOTE: The GC thread consumed the regions of the submitted request in place,
+  // so the retry starts over from the copy made when it was submitted.  Only
+  // the objtable destination region is replaced, and it lies beyond the
+  // original GC destination region.  The B and C layers themselves cannot have
+  // changed since, but a resize may have moved them to a new CB.
+  ret = logged_region_create(&thread_cb,
+                             &tmp_region,
+                             1,
+                             gc_submitted_request.objtable_worst_size,
+                             CB_REGION_FINAL);
+  assert(ret == 0);
+
+  memset(rr.mp(), 0, sizeof(struct gc_request_response));
+  rr.mp()->req = gc_submitted_request;
+  rr.mp()->req.objtable_new_region = tmp_region;
+  rr.mp()->req.gc_retry_region_start = cb_region_start(&tmp_region);
+  rr.mp()->req.gc_retry_region_end = cb_region_end(&tmp_region);
+  assert(rr.cp()->req.objtable_b.sm_offset == thread_objtable.b.sm_offset);
+  assert(rr.cp()->req.objtable_c.sm_offset == thread_objtable.c.sm_offset);
+  objtablelayer_assign(&(rr.mp()->req.objtable_b), &(thread_objtable.b));
+  objtablelayer_assign(&(rr.mp()->req.objtable_c), &(thread_objtable.c));
+
+  rr.mp()->req.orig_cb = thread_cb;  //NOTE: Finally set it just before we send, to ensure we're through all allocations.
+
+  gc_submitted_request = rr.cp()->req;
+  gc_submit_request(rr.mp());
+}
+
 void integrateGCResponse(struct gc_request_response *rr) {
   exec_phase = EXEC_PHASE_INTEGRATE_RESULT;
 
@@ -1357,8 +1610,17 @@ void integrateGCResponse(struct gc_request_response *rr) {
     cb_memcpy(thread_cb, rr->req.gc_dest_region_start,
               rr->req.orig_cb, rr->req.gc_dest_region_start,
               (rr->req.gc_dest_region_end - rr->req.gc_dest_region_start));
+    if (rr->req.gc_retry_region_start != CB_NULL) {
+      cb_memcpy(thread_cb, rr->req.gc_retry_region_start,
+                rr->req.orig_cb, rr->req.gc_retry_region_start,
+                (rr->req.gc_retry_region_end - rr->req.gc_retry_region_start));
+    }
   }
 
+  objtable_consolidation_fill =
+    (double)(cb_region_cursor(&(rr->req.objtable_new_region)) - cb_region_start(&(rr->req.objtable_new_region)))
+    / (double)rr->req.objtable_worst_size;
+
   // Cache the current frame's ip_offset, so that we'll later derive the correct
   // ip under revised objtable locations.
   size_t currentFrameIpOffset;
@@ -1471,27 +1733,11 @@ void integrateGCResponse(struct gc_request_response *rr) {
 
   size_t advance_len = rr->req.new_lower_bound - cb_start(thread_cb);
 
-#ifdef DEBUG_CLOBBER
-  if (advance_len > 0) {
-    //Clobber old contents.
-#ifdef DEBUG_TRACE_GC
-    KLOX_TRACE("clobbering range [%ju,%ju) of cb %p (size: %ju, start: %ju, cursor: %ju)\n",
-               (uintmax_t)cb_start(thread_cb),
-               (uintmax_t)rr->req.new_lower_bound,
-               thread_cb,
-               (uintmax_t)cb_ring_size(thread_cb),
-               (uintmax_t)cb_start(thread_cb),
-               (uintmax_t)cb_cursor(thread_cb));
-#endif  //DEBUG_TRACE_GC
-    cb_memset(thread_cb, cb_start(thread_cb), '@', advance_len);
-  }
-#endif  //DEBUG_CLOBBER
-
   KLOX_TRACE("cb_start_advance() by %ju bytes (from %ju to %ju)\n",
       (uintmax_t)advance_len,
       (uintmax_t)cb_start(thread_cb),
       (uintmax_t)(cb_start(thread_cb) + advance_len));
-  cb_start_advance(thread_cb, advance_len);
+  ring_reclaim(thread_cb, advance_len);
 
   // Adjust the heap size based on live memory.
   vm.nextGC = vm.bytesAllocated * GC_HEAP_GROW_FACTOR;
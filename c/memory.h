@@ -5,8 +5,18 @@
 #include "object.h"
 #include "trace.h"
 
+//NOTE: Each allocation's size, alignment and isObject flag are only recorded in
+// a header preceding it in debug builds, where they serve to check the
+// consistency of reallocate() calls and to render objtable entries.  Release
+// builds have no use for them, so there allocations carry no header (and so
+// need no slack for aligning beyond one).
+#ifndef NDEBUG
 static const size_t alloc_header_size = sizeof(size_t) + sizeof(size_t) + sizeof(bool);
 static const size_t alloc_header_align = sizeof(size_t);
+#else
+static const size_t alloc_header_size = 0;
+static const size_t alloc_header_align = 1;
+#endif
 
 // This is only ever used on non-Obj allocations.
 #define ALLOCATE(type, count) \
@@ -95,12 +105,16 @@ logged_free_array(const char *typeName, cb_offset_t previous, size_t typeSize, s
 }
 
 
+#ifndef NDEBUG
 bool alloc_is_object_get(const char *mem);
 size_t alloc_size_get(const char *mem);
 size_t alloc_alignment_get(const char *mem);
+#endif
 
 bool isWhite(Value value);
-void grayObjectLeaves(const OID<Obj> objectOID);
+// The most gray objects whose leaves grayObjectLeaves() darkens in one call.
+#define GRAY_LEAVES_BATCH_MAX 16
+void grayObjectLeaves(const OID<Obj> *objectOIDs, unsigned int n);
 bool objectIsDark(const OID<Obj> objectOID);
 cb_offset_t deriveMutableObjectLayer(struct cb **cb, struct cb_region *region, ObjID id, cb_offset_t object_offset);
 cb_offset_t cloneObject(struct cb **cb, struct cb_region *region, ObjID id, cb_offset_t object_offset);
@@ -111,6 +125,7 @@ void clearDedupeObjectSet(void);
 void addToDedupeObjectSet(cb_offset_t obj_offset);
 bool dedupeObject(cb_offset_t *obj_offset);
 void collectGarbage();
+void retryOverflowedGCRequest();
 void integrateGCResponse(struct gc_request_response *rr);
 
 #endif
@@ -4,6 +4,7 @@
 #include "cb_integration.h"
 #include "cb_bst.h"
 
+#include "hashmap.h"
 #include "memory.h"
 #include "object.h"
 #include "table.h"
@@ -21,8 +22,12 @@ objTypeString(ObjType objType)
     case OBJ_BOUND_METHOD: return "ObjBoundMethod";
     case OBJ_CLASS:        return "ObjClass";
     case OBJ_CLOSURE:      return "ObjClosure";
+    case OBJ_F64ARRAY:     return "ObjF64Array";
     case OBJ_FUNCTION:     return "ObjFunction";
+    case OBJ_HASHMAP:      return "ObjHashMap";
     case OBJ_INSTANCE:     return "ObjInstance";
+    case OBJ_LIST:         return "ObjList";
+    case OBJ_MAP:          return "ObjMap";
     case OBJ_NATIVE:       return "ObjNative";
     case OBJ_STRING:       return "ObjString";
     case OBJ_UPVALUE:      return "ObjUpvalue";
@@ -101,6 +106,19 @@ OID<ObjClosure> newClosure(OID<ObjFunction> function) {
   return assignObjectToID(closureCBO.co());
 }
 
+OID<ObjF64Array> newF64Array(int count) {
+  PIN_SCOPE;
+  CBO<double> valuesCBO = ALLOCATE(double, count);
+  CBO<ObjF64Array> arrayCBO = ALLOCATE_OBJ(ObjF64Array, OBJ_F64ARRAY);
+
+  ObjF64Array* array = arrayCBO.mlp().mp();  //cb-resize-safe (no allocations in lifetime)
+  array->count = count;
+  array->values = valuesCBO;
+  if (count > 0)
+    memset(array->values.mlp().mp(), 0, count * sizeof(double));
+  return assignObjectToID(arrayCBO.co());
+}
+
 OID<ObjFunction> newFunction() {
   CBO<ObjFunction> functionCBO = ALLOCATE_OBJ(ObjFunction, OBJ_FUNCTION);
   ObjFunction* function = functionCBO.mlp().mp();  //cb-resize-safe (no allocations in lifetime)
@@ -112,6 +130,17 @@ OID<ObjFunction> newFunction() {
   return assignObjectToID(functionCBO.co());
 }
 
+OID<ObjHashMap> newHashMap() {
+  CBO<ObjHashMap> mapCBO = ALLOCATE_OBJ(ObjHashMap, OBJ_HASHMAP);
+  ObjHashMap* map = mapCBO.mlp().mp();  //cb-resize-safe (no allocations in lifetime)
+
+  map->count = 0;
+  map->tombstones = 0;
+  map->capacity = 0;
+  map->entries = CB_NULL;
+  return assignObjectToID(mapCBO.co());
+}
+
 OID<ObjInstance> newInstance(OID<ObjClass> klass) {
   CBO<ObjInstance> instanceCBO = ALLOCATE_OBJ(ObjInstance, OBJ_INSTANCE);
   int ret;
@@ -126,6 +155,166 @@ OID<ObjInstance> newInstance(OID<ObjClass> klass) {
   return assignObjectToID(instanceCBO.co());
 }
 
+OID<ObjList> newList(int capacity) {
+  PIN_SCOPE;
+  CBO<Value> valuesCBO = ALLOCATE(Value, capacity);
+  CBO<ObjList> listCBO = ALLOCATE_OBJ(ObjList, OBJ_LIST);
+
+  ObjList* list = listCBO.mlp().mp();  //cb-resize-safe (no allocations in lifetime)
+  list->count = 0;
+  list->capacity = capacity;
+  list->values = valuesCBO;
+  return assignObjectToID(listCBO.co());
+}
+
+OID<ObjMap> newMap() {
+  PIN_SCOPE;
+  CBO<ObjMap> mapCBO = ALLOCATE_OBJ(ObjMap, OBJ_MAP);
+  cb_offset_t root;
+  int ret;
+
+  (void)ret;
+
+  ret = map_bst_init(&thread_cb, &thread_region, &root);
+  assert(ret == 0);
+
+  ObjMap* map = mapCBO.mlp().mp();  //cb-resize-safe (no allocations in lifetime)
+  map->count = 0;
+  map->root = root;
+  map->floor = mapCBO.co();
+  return assignObjectToID(mapCBO.co());
+}
+
+bool mapGet(OID<ObjMap> map, Value key, Value *value) {
+  struct cb_term key_term;
+  struct cb_term value_term;
+  int ret;
+
+  cb_term_set_dbl(&key_term, valueToNum(key));
+
+  ret = cb_bst_lookup(thread_cb, map.clip().cp()->root, &key_term, &value_term);
+  if (ret != 0 || numToValue(cb_term_get_dbl(&value_term)).val == TOMBSTONE_VAL.val) {
+    return false;
+  }
+
+  *value = numToValue(cb_term_get_dbl(&value_term));
+  return true;
+}
+
+struct copy_map_entry_closure
+{
+  struct cb_region *dest_region;
+  cb_offset_t      *dest_root;
+};
+
+static int
+copy_map_entry(const struct cb_term *key_term,
+               const struct cb_term *value_term,
+               void                 *closure)
+{
+  struct copy_map_entry_closure *cl = (struct copy_map_entry_closure *)closure;
+
+  return cb_bst_insert(&thread_cb,
+                       cl->dest_region,
+                       cl->dest_root,
+                       cb_region_start(cl->dest_region),  //NOTE: full contents are mutable
+                       key_term,
+                       value_term);
+}
+
+// Yields a BST root from which a new version of the given map may be derived
+// by path-copying, along with the floor of that BST's nodes.  Nodes above
+// thread_cutoff_offset will outlive the next integration of a GC response, by
+// which point every version sharing them will have been consolidated into a
+// copy of its own, so these may be shared directly.  Nodes at or below it may
+// be reclaimed at that integration while the derived version lives on, so a
+// BST having any such nodes must first be copied out wholesale.
+static cb_offset_t mapDerivableRoot(OID<ObjMap> map, cb_offset_t *floor) {
+  const ObjMap *src = map.clip().cp();
+  cb_offset_t srcRoot = src->root;
+  struct cb_region region;
+  struct copy_map_entry_closure cl;
+  cb_offset_t root;
+  int ret;
+
+  (void)ret;
+
+  if (cb_offset_cmp(src->floor, thread_cutoff_offset) > 0) {
+    *floor = src->floor;
+    return srcRoot;
+  }
+
+  //NOTE: A dedicated region sized up front ensures that the cb cannot be
+  // resized underneath the traversal of the source BST.
+  ret = logged_region_create(&thread_cb,
+                             &region,
+                             cb_alignof(Value),
+                             cb_bst_size(thread_cb, srcRoot),
+                             CB_REGION_FINAL);
+  assert(ret == 0);
+
+  ret = map_bst_init(&thread_cb, &region, &root);
+  assert(ret == 0);
+
+  cl.dest_region = &region;
+  cl.dest_root   = &root;
+  ret = cb_bst_traverse(thread_cb, srcRoot, &copy_map_entry, &cl);
+  assert(ret == 0);
+
+  *floor = cb_region_start(&region);
+  return root;
+}
+
+static OID<ObjMap> mapDerive(OID<ObjMap> map, Value key, Value value, int countDelta) {
+  PIN_SCOPE;
+  //NOTE: Allocation of the new ObjMap comes first, as it may provoke a
+  // collection which moves thread_cutoff_offset past the BST of 'map'.
+  CBO<ObjMap> mapCBO = ALLOCATE_OBJ(ObjMap, OBJ_MAP);
+  cb_offset_t floor;
+  cb_offset_t root = mapDerivableRoot(map, &floor);
+  struct cb_term key_term;
+  struct cb_term value_term;
+  int ret;
+
+  (void)ret;
+
+  cb_term_set_dbl(&key_term, valueToNum(key));
+  cb_term_set_dbl(&value_term, valueToNum(value));
+
+  //NOTE: Every node which presently exists sits below the cb's cursor, so
+  // using it as the cutoff makes the insertion copy the path from the root
+  // rather than modify it, leaving 'map' itself untouched.
+  ret = cb_bst_insert(&thread_cb,
+                      &thread_region,
+                      &root,
+                      cb_cursor(thread_cb),
+                      &key_term,
+                      &value_term);
+  assert(ret == 0);
+
+  ObjMap* newMap = mapCBO.mlp().mp();  //cb-resize-safe (no allocations in lifetime)
+  newMap->count = map.clip().cp()->count + countDelta;
+  newMap->root = root;
+  newMap->floor = floor;
+  return assignObjectToID(mapCBO.co());
+}
+
+OID<ObjMap> mapSet(OID<ObjMap> map, Value key, Value value) {
+  Value existing;
+  bool isNew = !mapGet(map, key, &existing);
+
+  return mapDerive(map, key, value, isNew ? 1 : 0);
+}
+
+OID<ObjMap> mapRemove(OID<ObjMap> map, Value key) {
+  Value existing;
+
+  if (!mapGet(map, key, &existing))
+    return map;
+
+  return mapDerive(map, key, TOMBSTONE_VAL, -1);
+}
+
 OID<ObjNative> newNative(NativeFn function) {
   PIN_SCOPE;
   CBO<ObjNative> nativeCBO = ALLOCATE_OBJ(ObjNative, OBJ_NATIVE);
@@ -266,6 +455,32 @@ static void printFunction(ObjFunction* function) {
   printf("<fn %s>", function->name.clip().cp()->chars.clp().cp());
 }
 
+struct print_map_entry_closure
+{
+  bool first;
+};
+
+static int
+print_map_entry(const struct cb_term *key_term,
+                const struct cb_term *value_term,
+                void                 *closure)
+{
+  struct print_map_entry_closure *cl = (struct print_map_entry_closure *)closure;
+  Value value = numToValue(cb_term_get_dbl(value_term));
+
+  if (value.val == TOMBSTONE_VAL.val)
+    return 0;
+
+  if (!cl->first) printf(", ");
+  cl->first = false;
+
+  printValue(numToValue(cb_term_get_dbl(key_term)), true);
+  printf(": ");
+  printValue(value, true);
+
+  return 0;
+}
+
 void printObject(ObjID id, cb_offset_t offset, const Obj *obj, bool pretty) {
   if (!can_print)
     return;
@@ -355,6 +570,26 @@ void printObject(ObjID id, cb_offset_t offset, const Obj *obj, bool pretty) {
       break;
     }
 
+    case OBJ_F64ARRAY: {
+      const ObjF64Array *array = (const ObjF64Array *)obj;
+      if (pretty) {
+        const double *values = array->values.clp().cp();
+        printf("f64[");
+        for (int i = 0; i < array->count; ++i) {
+          printValue(NUMBER_VAL(values[i]), true);
+          if (i < array->count - 1) printf(", ");
+        }
+        printf("]");
+      } else {
+        printf("f64array#%ju@%ju,count:%d,values@%ju",
+               (uintmax_t)id.id,
+               (uintmax_t)offset,
+               array->count,
+               (uintmax_t)array->values.co());
+      }
+      break;
+    }
+
     case OBJ_FUNCTION: {
       const ObjFunction *fun = (const ObjFunction *)obj;
       if (fun->name.is_nil()) {
@@ -374,6 +609,36 @@ void printObject(ObjID id, cb_offset_t offset, const Obj *obj, bool pretty) {
       break;
     }
 
+    case OBJ_HASHMAP: {
+      const ObjHashMap *map = (const ObjHashMap *)obj;
+      if (pretty) {
+        bool first = true;
+        printf("{");
+        if (map->capacity > 0) {
+          const HashMapEntry *entries = map->entries.clp().cp();
+          const uint8_t *ctrl = hashMapCtrl(entries, map->capacity);
+          for (int i = 0; i < map->capacity; ++i) {
+            if (!hashMapCtrlIsFull(ctrl[i])) continue;
+            if (!first) printf(", ");
+            first = false;
+            printValue(entries[i].key, true);
+            printf(": ");
+            printValue(entries[i].value, true);
+          }
+        }
+        printf("}");
+      } else {
+        printf("hashmap#%ju@%ju,count:%d,tombstones:%d,capacity:%d,entries@%ju",
+               (uintmax_t)id.id,
+               (uintmax_t)offset,
+               map->count,
+               map->tombstones,
+               map->capacity,
+               (uintmax_t)map->entries.co());
+      }
+      break;
+    }
+
     case OBJ_INSTANCE:
       if (pretty) {
         printf("%s instance",
@@ -393,6 +658,49 @@ void printObject(ObjID id, cb_offset_t offset, const Obj *obj, bool pretty) {
       }
       break;
 
+    case OBJ_LIST: {
+      const ObjList *list = (const ObjList *)obj;
+      if (pretty) {
+        const Value *values = list->values.clp().cp();
+        printf("[");
+        for (int i = 0; i < list->count; ++i) {
+          printValue(values[i], true);
+          if (i < list->count - 1) printf(", ");
+        }
+        printf("]");
+      } else {
+        printf("list#%ju@%ju,count:%d,capacity:%d,values@%ju",
+               (uintmax_t)id.id,
+               (uintmax_t)offset,
+               list->count,
+               list->capacity,
+               (uintmax_t)list->values.co());
+      }
+      break;
+    }
+
+    case OBJ_MAP: {
+      const ObjMap *map = (const ObjMap *)obj;
+      if (pretty) {
+        struct print_map_entry_closure cl = { true };
+        int ret;
+
+        (void)ret;
+
+        printf("{");
+        ret = cb_bst_traverse(thread_cb, map->root, &print_map_entry, &cl);
+        assert(ret == 0);
+        printf("}");
+      } else {
+        printf("map#%ju@%ju,count:%d,root@%ju",
+               (uintmax_t)id.id,
+               (uintmax_t)offset,
+               map->count,
+               (uintmax_t)map->root);
+      }
+      break;
+    }
+
     case OBJ_NATIVE:
       if (pretty) {
         printf("<native fn>");
@@ -12,16 +12,24 @@
 #define IS_BOUND_METHOD(value)  isObjType(value, OBJ_BOUND_METHOD)
 #define IS_CLASS(value)         isObjType(value, OBJ_CLASS)
 #define IS_CLOSURE(value)       isObjType(value, OBJ_CLOSURE)
+#define IS_F64ARRAY(value)      isObjType(value, OBJ_F64ARRAY)
 #define IS_FUNCTION(value)      isObjType(value, OBJ_FUNCTION)
+#define IS_HASHMAP(value)       isObjType(value, OBJ_HASHMAP)
 #define IS_INSTANCE(value)      isObjType(value, OBJ_INSTANCE)
+#define IS_LIST(value)          isObjType(value, OBJ_LIST)
+#define IS_MAP(value)           isObjType(value, OBJ_MAP)
 #define IS_NATIVE(value)        isObjType(value, OBJ_NATIVE)
 #define IS_STRING(value)        isObjType(value, OBJ_STRING)
 
 #define AS_BOUND_METHOD_OID(value)  (OID<ObjBoundMethod>(AS_OBJ_ID(value)))
 #define AS_CLASS_OID(value)         (OID<ObjClass>(AS_OBJ_ID(value)))
 #define AS_CLOSURE_OID(value)       (OID<ObjClosure>(AS_OBJ_ID(value)))
+#define AS_F64ARRAY_OID(value)      (OID<ObjF64Array>(AS_OBJ_ID(value)))
 #define AS_FUNCTION_OID(value)      (OID<ObjFunction>(AS_OBJ_ID(value)))
+#define AS_HASHMAP_OID(value)       (OID<ObjHashMap>(AS_OBJ_ID(value)))
 #define AS_INSTANCE_OID(value)      (OID<ObjInstance>(AS_OBJ_ID(value)))
+#define AS_LIST_OID(value)          (OID<ObjList>(AS_OBJ_ID(value)))
+#define AS_MAP_OID(value)           (OID<ObjMap>(AS_OBJ_ID(value)))
 #define AS_UPVALUE_OID(value)      (OID<ObjUpvalue>(AS_OBJ_ID(value)))
 #define AS_NATIVE(value)        ((OID<ObjNative>(AS_OBJ_ID(value)).clip().cp())->function)
 #define AS_STRING_OID(value)        (OID<ObjString>(AS_OBJ_ID(value)))
@@ -30,8 +38,12 @@ typedef enum {
   OBJ_BOUND_METHOD,
   OBJ_CLASS,
   OBJ_CLOSURE,
+  OBJ_F64ARRAY,
   OBJ_FUNCTION,
+  OBJ_HASHMAP,
   OBJ_INSTANCE,
+  OBJ_LIST,
+  OBJ_MAP,
   OBJ_NATIVE,
   OBJ_STRING,
   OBJ_UPVALUE
@@ -107,11 +119,61 @@ typedef struct {
   OID<ObjClosure> method;
 } ObjBoundMethod;
 
+typedef struct {
+  Obj obj;
+  int count;
+  int capacity;
+  CBO<Value> values;  //Value[] (contiguous, 'capacity' slots of which 'count' are live).
+} ObjList;
+
+// A persistent map.  ObjMaps are never mutated once created; mapSet() and
+// mapRemove() instead produce a new ObjMap whose cb_bst shares all untouched
+// nodes with that of the original.  Removed keys are held as TOMBSTONE_VAL
+// entries so that removal may path-copy as well.  Keys are ordered by value for
+// numbers and strings, and by identity for all other objects.
+typedef struct {
+  Obj obj;
+  int count;  //live (non-tombstone) entries
+  cb_offset_t root;  //cb_bst of Value -> Value
+  cb_offset_t floor;  //no node of root's cb_bst lies below this offset
+} ObjMap;
+
+// A fixed-length array of unboxed doubles, for use by the vectorized kernels
+// of f64array.h.  Holds no references to other objects.
+typedef struct {
+  Obj obj;
+  int count;
+  CBO<double> values;  //double[count]
+} ObjF64Array;
+
+typedef struct {
+  Value key;
+  Value value;
+} HashMapEntry;
+
+// A mutable hash map using open addressing.  The slots and their control bytes
+// share a single allocation so that the whole table can be carried between
+// layers with one copy.
+typedef struct {
+  Obj obj;
+  int count;       //live entries
+  int tombstones;  //deleted slots not yet reclaimed by a rehash
+  int capacity;    //slots; zero or a multiple of HASHMAP_GROUP_WIDTH
+  CBO<HashMapEntry> entries;  //HashMapEntry[capacity], followed by 'capacity' control bytes.
+} ObjHashMap;
+
 OID<ObjBoundMethod> newBoundMethod(Value receiver, OID<ObjClosure> method);
 OID<ObjClass> newClass(OID<ObjString> name);
 OID<ObjClosure> newClosure(OID<ObjFunction> function);
+OID<ObjF64Array> newF64Array(int count);
 OID<ObjFunction> newFunction();
+OID<ObjHashMap> newHashMap();
 OID<ObjInstance> newInstance(OID<ObjClass> klass);
+OID<ObjList> newList(int capacity);
+OID<ObjMap> newMap();
+bool mapGet(OID<ObjMap> map, Value key, Value *value);
+OID<ObjMap> mapSet(OID<ObjMap> map, Value key, Value value);
+OID<ObjMap> mapRemove(OID<ObjMap> map, Value key);
 OID<ObjNative> newNative(NativeFn function);
 OID<ObjString> rawAllocateString(const char* chars, int length);
 OID<ObjString> takeString(CBO<char> /*char[]*/ chars, int length);
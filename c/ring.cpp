@@ -0,0 +1,421 @@
+#include <assert.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include "cb_integration.h"
+#include "ring.h"
+#include "trace.h"
+
+#ifndef MAP_HUGE_SHIFT
+#define MAP_HUGE_SHIFT 26
+#endif
+#ifndef MAP_HUGE_2MB
+#define MAP_HUGE_2MB (21 << MAP_HUGE_SHIFT)
+#endif
+#ifndef MAP_HUGE_1GB
+#define MAP_HUGE_1GB (30 << MAP_HUGE_SHIFT)
+#endif
+
+// Where the ring's backing files are placed when hugetlbfs pages are requested.
+#define RING_HUGETLBFS_DIR_DEFAULT "/dev/hugepages"
+
+// The smallest ring, 1 page.
+#define RING_SIZE_MIN ((size_t)1 << 12)
+
+// The ring size estimated for a script is RING_BYTES_PER_SOURCE_BYTE times its
+// source size, plus RING_OBJTABLE_SIZES times the size of an objtable layer.
+//NOTE: Compilation keeps its whole output pinned, and the former roughly covers
+// the chunks, constants and string interning of typical source.  The latter
+// dominates for small scripts: the A, B and C layers and a GC's new B layer
+// are each a large, fixed-size first level, and a GC needs the ring to have as
+// much again free.
+#define RING_BYTES_PER_SOURCE_BYTE 64
+#define RING_OBJTABLE_SIZES        8
+
+// Growing ahead is done once the ring's data exceeds 1/RING_GROW_AHEAD_LOAD of
+// the ring, and grows it to at least RING_GROW_AHEAD_FACTOR times that data.
+#define RING_GROW_AHEAD_LOAD   2
+#define RING_GROW_AHEAD_FACTOR 2
+
+// With KLOX_RING_RELEASE set, the ring is halved once its data has stayed
+// below 1/RING_SHRINK_LOAD of it for RING_SHRINK_PERIOD consecutive GCs.
+#define RING_SHRINK_LOAD   8
+#define RING_SHRINK_PERIOD 16
+
+#define RING_HINT_SUFFIX ".ringhint"
+
+RingPages ring_pages = RING_PAGES_NORMAL;
+
+static char *hintPath = NULL;
+static size_t hintedRingSize = 0;
+static size_t neededRingSize = 0;
+static bool ringAutoSized = false;
+static bool ringLocked = false;
+static size_t ringSizeFloor = RING_SIZE_MIN;
+static struct timespec resizeBegin;
+static unsigned int idleGCCount = 0;
+
+// The release of reclaimed ring pages to the OS, on a background thread.
+//NOTE: Ranges are handed over under the mutex as [first, end), and one handed
+// over before the thread has taken the last is merged into it (they are
+// contiguous).  Their completion is observed by the main thread through the
+// atomic alone.  This is never destroyed, as the thread waits upon it until
+// exit.
+struct RingRelease {
+  std::mutex               mutex;
+  std::condition_variable  cond;
+  struct cb               *cb;
+  cb_offset_t              first;
+  cb_offset_t              end;
+  std::atomic<cb_offset_t> releasedEnd;
+};
+
+static RingRelease *release = NULL;
+static bool releasePending = false;  //whether handed over pages await release
+static cb_offset_t releaseEnd;       //the end of all pages handed over
+static cb_offset_t releaseTarget;    //where the ring's start goes after them
+
+static RingPages requestedRingPages() {
+  const char *mode = getenv("KLOX_HUGEPAGES");
+
+  if (!mode) return RING_PAGES_NORMAL;
+  if (strcmp(mode, "thp") == 0) return RING_PAGES_THP;
+  if (strcmp(mode, "2M") == 0) return RING_PAGES_HUGETLB_2MB;
+  if (strcmp(mode, "1G") == 0) return RING_PAGES_HUGETLB_1GB;
+  return RING_PAGES_NORMAL;
+}
+
+static size_t hugePageSize(RingPages pages) {
+  switch (pages) {
+    case RING_PAGES_THP:         return (size_t)1 << 21;
+    case RING_PAGES_HUGETLB_2MB: return (size_t)1 << 21;
+    case RING_PAGES_HUGETLB_1GB: return (size_t)1 << 30;
+    case RING_PAGES_NORMAL:      break;
+  }
+  return 0;
+}
+
+// The granularity at which ring memory can be released.
+static size_t ringPageSize() {
+  size_t pageSize = hugePageSize(ring_pages);
+  return (pageSize ? pageSize : (size_t)sysconf(_SC_PAGESIZE));
+}
+
+static size_t powerOf2AtLeast(size_t x) {
+  size_t p = RING_SIZE_MIN;
+  while (p < x) p <<= 1;
+  return p;
+}
+
+static void noteNeededRingSize(size_t size) {
+  if (size > neededRingSize) neededRingSize = size;
+}
+
+size_t ring_initial_size(const char *path) {
+  const char *explicitSize = getenv("KLOX_RING_SIZE");
+  if (explicitSize) {
+    uintmax_t size = RING_SIZE_MIN;
+    sscanf(explicitSize, "%ju", &size);
+    return (size_t)size;
+  }
+
+  ringAutoSized = true;
+  if (!path) return RING_SIZE_MIN;
+
+  size_t size = RING_SIZE_MIN;
+  struct stat st;
+  if (stat(path, &st) == 0) {
+    size = RING_OBJTABLE_SIZES * sizeof(ObjTableSM) + (size_t)st.st_size * RING_BYTES_PER_SOURCE_BYTE;
+  }
+
+  if (getenv("KLOX_RING_HINTS")) {
+    hintPath = (char *)malloc(strlen(path) + sizeof(RING_HINT_SUFFIX));
+    strcpy(hintPath, path);
+    strcat(hintPath, RING_HINT_SUFFIX);
+
+    FILE *file = fopen(hintPath, "r");
+    if (file) {
+      uintmax_t hint;
+      if (fscanf(file, "%ju", &hint) == 1) hintedRingSize = (size_t)hint;
+      fclose(file);
+    }
+    if (hintedRingSize > size) size = hintedRingSize;
+  }
+
+  return powerOf2AtLeast(size);
+}
+
+void ring_resize_ahead(struct cb **cb) {
+  size_t ringSize = cb_ring_size(*cb);
+  size_t dataSize = cb_data_size(*cb);
+
+  noteNeededRingSize(powerOf2AtLeast(dataSize * RING_GROW_AHEAD_FACTOR));
+
+  //NOTE: The ring never shrinks below the size it was created with, which is
+  // also at least one huge page when those back it.
+  if (release && dataSize < ringSize / RING_SHRINK_LOAD && ringSize / 2 >= ringSizeFloor) {
+    if (++idleGCCount >= RING_SHRINK_PERIOD) {
+      idleGCCount = 0;
+      KLOX_TRACE("shrinking idle ring from %zu to %zu bytes (data: %zu bytes)\n", ringSize, ringSize / 2, dataSize);
+      int ret = cb_resize(cb, ringSize / 2);
+      (void)ret;
+      if (ret != 0) KLOX_TRACE("failed to shrink ring\n");
+    }
+    return;
+  }
+  idleGCCount = 0;
+
+  if (dataSize <= ringSize / RING_GROW_AHEAD_LOAD) return;
+
+  size_t newRingSize = powerOf2AtLeast(dataSize * RING_GROW_AHEAD_FACTOR);
+  KLOX_TRACE("growing ring ahead of need from %zu to %zu bytes (data: %zu bytes)\n", ringSize, newRingSize, dataSize);
+
+  //NOTE: Failure here is not fatal; the ring will instead grow on demand.
+  int ret = cb_resize(cb, newRingSize);
+  (void)ret;
+  if (ret != 0) KLOX_TRACE("failed to grow ring ahead of need\n");
+}
+
+static void releaseThreadMain() {
+  for (;;) {
+    struct cb *cb;
+    cb_offset_t first;
+    cb_offset_t end;
+
+    {
+      std::unique_lock<std::mutex> lock(release->mutex);
+      release->cond.wait(lock, [] { return release->first != release->end; });
+      cb = release->cb;
+      first = release->first;
+      end = release->end;
+      release->first = release->end;
+    }
+
+    //NOTE: The ring is mapped twice in succession, so the range is contiguous
+    // in memory even where it wraps around the end of the ring.
+    char *addr = (char *)cb_at(cb, first);
+    size_t len = end - first;
+
+    //NOTE: Locked pages cannot be released, so the range is first unlocked.
+    // MADV_REMOVE frees the backing pages of a shared ring, and thereby both of
+    // its mappings.  Should it be unsupported, MADV_DONTNEED at least drops
+    // this mapping's pages.  A locked ring's range is then locked again, but
+    // only on fault, so that its pages come back locked when they are reused
+    // without being populated here.
+    munlock(addr, len);
+    if (madvise(addr, len, MADV_REMOVE) != 0) madvise(addr, len, MADV_DONTNEED);
+    if (ringLocked) mlock2(addr, len, MLOCK_ONFAULT);
+
+    release->releasedEnd.store(end, std::memory_order_release);
+  }
+}
+
+static bool releaseIsDone() {
+  return release->releasedEnd.load(std::memory_order_acquire) == releaseEnd;
+}
+
+static void awaitRelease() {
+  if (!releasePending) return;
+  while (!releaseIsDone()) std::this_thread::yield();
+}
+
+void ring_reclaim_init(void) {
+  if (!getenv("KLOX_RING_RELEASE")) return;
+
+  release = new RingRelease();
+  release->cb = NULL;
+  release->first = release->end = 0;
+  release->releasedEnd.store(0, std::memory_order_relaxed);
+  std::thread(releaseThreadMain).detach();
+}
+
+void ring_reclaim(struct cb *cb, size_t advance_len) {
+  cb_offset_t start = cb_start(cb);
+  cb_offset_t target = start + advance_len;
+
+#ifdef DEBUG_CLOBBER
+  {
+    //NOTE: Pages handed over for release are left alone, as the release
+    // thread may be removing them.
+    cb_offset_t clobberStart = (releasePending ? releaseTarget : start);
+    if (cb_offset_cmp(clobberStart, target) < 0) {
+#ifdef DEBUG_TRACE_GC
+      KLOX_TRACE("clobbering range [%ju,%ju) of cb %p (size: %ju, start: %ju, cursor: %ju)\n",
+                 (uintmax_t)clobberStart,
+                 (uintmax_t)target,
+                 cb,
+                 (uintmax_t)cb_ring_size(cb),
+                 (uintmax_t)start,
+                 (uintmax_t)cb_cursor(cb));
+#endif  //DEBUG_TRACE_GC
+      cb_memset(cb, clobberStart, '@', target - clobberStart);
+    }
+  }
+#endif  //DEBUG_CLOBBER
+
+  if (!release) {
+    cb_start_advance(cb, advance_len);
+    return;
+  }
+
+  if (releasePending && releaseIsDone()) {
+    releasePending = false;
+    cb_start_advance(cb, releaseTarget - start);
+    start = releaseTarget;
+  }
+
+  //NOTE: Until their release completes, pages handed over must stay below the
+  // start of the ring, lest they be reused and then released out from under
+  // their new contents.  Meanwhile, further whole pages are handed over after
+  // them, and the start is only advanced (to the latest target) once all are
+  // released.
+  size_t pageSize = ringPageSize();
+  cb_offset_t firstPage = (releasePending ? releaseEnd : cb_offset_aligned_gte(start, pageSize));
+  cb_offset_t endPage = target & ~(cb_offset_t)(pageSize - 1);
+
+  if (cb_offset_cmp(firstPage, endPage) >= 0) {
+    if (releasePending) {
+      releaseTarget = target;
+    } else {
+      cb_start_advance(cb, target - start);
+    }
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(release->mutex);
+    if (release->first == release->end) release->first = firstPage;
+    release->end = endPage;
+    release->cb = cb;
+  }
+  release->cond.notify_one();
+  releasePending = true;
+  releaseEnd = endPage;
+  releaseTarget = target;
+  KLOX_TRACE("releasing ring range [%ju,%ju)\n", (uintmax_t)firstPage, (uintmax_t)endPage);
+}
+
+void ring_resize_begin(void) {
+  //NOTE: A release under way addresses the old ring's mapping.
+  awaitRelease();
+  clock_gettime(CLOCK_MONOTONIC, &resizeBegin);
+}
+
+void ring_resize_end(struct cb *old_cb, struct cb *new_cb) {
+  struct timespec resizeEnd;
+  clock_gettime(CLOCK_MONOTONIC, &resizeEnd);
+
+  noteNeededRingSize(cb_ring_size(new_cb));
+
+  if (getenv("KLOX_RING_LOG")) {
+    double ms = (double)(resizeEnd.tv_sec - resizeBegin.tv_sec) * 1e3 +
+                (double)(resizeEnd.tv_nsec - resizeBegin.tv_nsec) / 1e6;
+    fprintf(stderr, "Ring resized from %zu to %zu bytes, stalling %.3f ms.\n",
+            cb_ring_size(old_cb), cb_ring_size(new_cb), ms);
+  }
+}
+
+void ring_save_hint(void) {
+  if (!hintPath) return;
+
+  //NOTE: The ring this run started with may have been sized by the hint
+  // itself, so it is what the run needed which is saved.  Should that be less
+  // than the hint, the hint is only halved, so that one lean run does not
+  // undo what the script usually needs.
+  size_t hint = neededRingSize;
+  if (hint < hintedRingSize / 2) hint = hintedRingSize / 2;
+  if (hint == hintedRingSize) return;
+
+  FILE *file = fopen(hintPath, "w");
+  if (!file) return;
+  fprintf(file, "%zu\n", hint);
+  fclose(file);
+  hintedRingSize = hint;
+}
+
+struct cb *ring_create(struct cb_params *params) {
+  RingPages pages = requestedRingPages();
+  struct cb_params normalParams = *params;
+  struct cb *cb;
+
+  if (ringAutoSized) {
+    //NOTE: The estimated size is generous (the objtable layers alone are tens
+    // of MBs), so rather than populating and locking all of it up front, its
+    // pages are left to fault in as they are first used.  Only a ring of an
+    // explicit KLOX_RING_SIZE is populated and locked as requested.
+    normalParams.mmap_flags &= ~MAP_POPULATE;
+    normalParams.flags &= ~CB_PARAMS_F_MLOCK;
+  }
+  ringLocked = (normalParams.flags & CB_PARAMS_F_MLOCK) != 0;
+
+  struct cb_params hugeParams = normalParams;
+
+  if (pages != RING_PAGES_NORMAL) {
+    //NOTE: A ring smaller than one huge page cannot benefit, and those which
+    // are larger must be a multiple of it.  Ring sizes are powers of 2 and
+    // double on resize, so rounding up here suffices for the ring's lifetime.
+    size_t pageSize = hugePageSize(pages);
+    if (hugeParams.ring_size < pageSize) hugeParams.ring_size = pageSize;
+  }
+
+  if (pages == RING_PAGES_HUGETLB_2MB || pages == RING_PAGES_HUGETLB_1GB) {
+    //NOTE: The ring is a file mapped twice in succession, so hugetlb pages
+    // require that file to reside on a hugetlbfs mount (one with a matching
+    // pagesize= option, if not the system default).
+    const char *dir = getenv("KLOX_HUGETLBFS_DIR");
+    if (!dir) dir = RING_HUGETLBFS_DIR_DEFAULT;
+    snprintf(hugeParams.filename_prefix, sizeof(hugeParams.filename_prefix), "%s/map-", dir);
+    hugeParams.mmap_flags |= MAP_HUGETLB | (pages == RING_PAGES_HUGETLB_2MB ? MAP_HUGE_2MB : MAP_HUGE_1GB);
+
+    cb = cb_create(&hugeParams, sizeof(hugeParams));
+    if (cb) {
+      ring_pages = pages;
+      ringSizeFloor = hugeParams.ring_size;
+      KLOX_TRACE("created ring of %zu bytes on hugetlbfs pages\n", hugeParams.ring_size);
+      return cb;
+    }
+
+    fprintf(stderr, "Could not create ring on hugetlbfs pages under \"%s\", using normal pages.\n", dir);
+    pages = RING_PAGES_NORMAL;
+  }
+
+  if (pages == RING_PAGES_THP) {
+    cb = cb_create(&hugeParams, sizeof(hugeParams));
+    if (cb) {
+      ring_pages = pages;
+      ringSizeFloor = hugeParams.ring_size;
+      ring_advise(cb);
+    }
+    return cb;
+  }
+
+  ring_pages = RING_PAGES_NORMAL;
+  ringSizeFloor = normalParams.ring_size;
+  return cb_create(&normalParams, sizeof(normalParams));
+}
+
+void ring_advise(struct cb *cb) {
+  if (ring_pages != RING_PAGES_THP) return;
+
+  //NOTE: Each of the ring's two mappings is advised separately, as they need
+  // not be a single VMA.  For a shared (file-backed) ring, the kernel honors
+  // this only when /sys/kernel/mm/transparent_hugepage/shmem_enabled permits.
+  // Pages already populated are collapsed into huge pages later by khugepaged.
+  char *start = (char *)cb_ring_start(cb);
+  size_t size = cb_ring_size(cb);
+  if (madvise(start, size, MADV_HUGEPAGE) != 0 ||
+      madvise(start + size, size, MADV_HUGEPAGE) != 0) {
+    fprintf(stderr, "Could not advise transparent huge pages for ring (%s), using normal pages.\n", strerror(errno));
+    ring_pages = RING_PAGES_NORMAL;
+  }
+}
@@ -0,0 +1,65 @@
+#ifndef klox_ring_h
+#define klox_ring_h
+
+#include <cb.h>
+
+// The kind of pages backing the cb ring, as selected by the KLOX_HUGEPAGES
+// environment variable ("thp", "2M" or "1G"; anything else means normal pages).
+//NOTE: The ring is sized in the GBs for the larger benchmarks, and every Obj
+// dereference and objtable walk goes through it, so with 4 KB pages most of
+// those accesses miss the TLB.
+typedef enum {
+  RING_PAGES_NORMAL,
+  RING_PAGES_THP,          // transparent huge pages, via madvise(MADV_HUGEPAGE)
+  RING_PAGES_HUGETLB_2MB,  // hugetlbfs, 2 MB pages
+  RING_PAGES_HUGETLB_1GB   // hugetlbfs, 1 GB pages
+} RingPages;
+
+extern RingPages ring_pages;
+
+// Creates the cb per params, backed by the kind of pages requested in the
+// environment.  Should huge pages be unavailable, this warns and falls back to
+// normal pages.  A ring sized by ring_initial_size()'s estimate is neither
+// populated nor locked, whatever params asks for.
+struct cb *ring_create(struct cb_params *params);
+
+// The initial ring size for running the script at path (NULL for the REPL).
+// An explicit KLOX_RING_SIZE is always honored.  Otherwise this is the larger
+// of an estimate from the script's size and, when KLOX_RING_HINTS is set, the
+// size hinted by the script's previous runs (as persisted by ring_save_hint()).
+size_t ring_initial_size(const char *path);
+
+// Grows the ring ahead of need, when its data has come to occupy more than
+// half of it.  This is called at GC boundaries so that resizes are taken there,
+// in bulk, rather than in the midst of a GC cycle (where the GC's output would
+// then also need copying into the new ring).  With KLOX_RING_RELEASE set, this
+// also shrinks a ring whose data has stayed far below its size, though never
+// below the size it was created with.
+void ring_resize_ahead(struct cb **cb);
+
+// Starts the background release of reclaimed ring memory, if KLOX_RING_RELEASE
+// is set.
+void ring_reclaim_init(void);
+
+// Advances the start of the ring by advance_len, reclaiming the space before
+// it.  With KLOX_RING_RELEASE set, the whole pages reclaimed (huge pages, if
+// those back the ring) are also released to the OS, which is done on a
+// background thread.  The ring's start is held back over those pages until
+// their release is seen to have completed at a later reclamation.  With
+// DEBUG_CLOBBER, the reclaimed space not under release is clobbered.
+void ring_reclaim(struct cb *cb, size_t advance_len);
+
+// Bracket each cb resize, timing the stall.  With KLOX_RING_LOG set, each is
+// reported on stderr.
+void ring_resize_begin(void);
+void ring_resize_end(struct cb *old_cb, struct cb *new_cb);
+
+// Persists the ring size which this run needed as the script's size hint, if
+// KLOX_RING_HINTS is set.  A hint larger than that need is halved instead.
+void ring_save_hint(void);
+
+// Applies the page advice of ring_pages to the ring of cb.  This must be
+// repeated for each new ring after a cb resize.
+void ring_advise(struct cb *cb);
+
+#endif
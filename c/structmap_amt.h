@@ -8,6 +8,10 @@
 #include <cb.h>
 #include <cb_region.h>
 
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
 #if NDEBUG
 #define DEBUG_ONLY(x)
 #else
@@ -75,6 +79,18 @@ struct structmap_amt
   unsigned int           node_count_;
   size_t                 total_external_size;
   structmap_value_size_t sizeof_value;
+
+  // Bit i is set iff entries[i] is not STRUCTMAP_AMT_ENTRY_EMPTY.  This lets
+  // traversal skip over runs of empty first-level entries 64 at a time, which
+  // matters for the (very wide) first level of the ObjTable.
+  //NOTE: Narrower first levels go without, as the bitmap would cost more than
+  // the scan it saves.  In particular, the single-entry first levels of the
+  // FieldsSM and MethodsSM embedded in every ObjInstance and ObjClass would
+  // each grow by 8 bytes for no benefit.
+  static const bool FIRSTLEVEL_OCCUPANCY_TRACKED = (FIRSTLEVEL_BITS >= 6);
+  static const unsigned int FIRSTLEVEL_OCCUPANCY_WORDS = (FIRSTLEVEL_OCCUPANCY_TRACKED ? (1 << FIRSTLEVEL_BITS) / 64 : 0);
+  uint64_t firstlevel_occupancy[FIRSTLEVEL_OCCUPANCY_WORDS];
+
   struct structmap_amt_entry entries[1 << FIRSTLEVEL_BITS];
 
   struct node
@@ -90,6 +106,9 @@ struct structmap_amt
 
   void init(structmap_value_size_t sizeof_value);
 
+  static uint64_t
+  node_occupancy(const node *n);
+
   int
   node_alloc(struct cb        **cb,
              struct cb_region  *region,
@@ -103,6 +122,36 @@ struct structmap_amt
   would_collide_node_count_slowpath(const struct cb *cb,
                                     uint64_t         key) const;
 
+  void
+  traverse_entry(const struct cb                  **cb,
+                 structmap_traverse_func_t          func,
+                 void                              *closure,
+                 const struct structmap_amt_entry  *entry) const
+  {
+    switch (entrytypeof(entry)) {
+      case STRUCTMAP_AMT_ENTRY_NODE: {
+        const node *child_node = (node *)cb_at_immed(&thread_cb_at_immed_param, entryoffsetof(entry));
+        traverse_node(cb, func, closure, child_node);
+        break;
+      }
+
+      case STRUCTMAP_AMT_ENTRY_ITEM:
+        func(entrykeyof(entry), entry->value, closure);
+        break;
+
+      case STRUCTMAP_AMT_ENTRY_EMPTY:
+        //NOTE: Empty entries are skipped via the occupancy masks.
+        assert(false);
+        break;
+
+#ifndef NDEBUG
+      default:
+        printf("Bogus structmap entry type: %d\n", entrytypeof(entry));
+        assert(false);
+#endif
+    }
+  }
+
   int
   traverse_node(const struct cb           **cb,
                 structmap_traverse_func_t   func,
@@ -155,6 +204,8 @@ struct structmap_amt
       const struct structmap_amt_entry *entry = &(this->entries[i]);
       (void)entry;
       assert(entrytypeof(entry) == STRUCTMAP_AMT_ENTRY_NODE || entrytypeof(entry) == STRUCTMAP_AMT_ENTRY_EMPTY || entrytypeof(entry) == STRUCTMAP_AMT_ENTRY_ITEM);
+      assert(!FIRSTLEVEL_OCCUPANCY_TRACKED
+             || !!(this->firstlevel_occupancy[i / 64] & ((uint64_t)1 << (i % 64))) == (entrytypeof(entry) != STRUCTMAP_AMT_ENTRY_EMPTY));
     }
   }
 
@@ -189,6 +240,54 @@ struct structmap_amt
     return false;
   }
 
+  // Looks up n keys, as lookup() would each, storing whether each was found
+  // into found[] and (if so) its value into values[].
+  //NOTE: The trie walks of all n keys proceed in lockstep, one level per pass,
+  // with the next entry of each key prefetched as soon as its address is known.
+  // The cache misses of the walks thereby overlap instead of being serialized.
+  static const unsigned int LOOKUP_BATCH_MAX = 16;
+
+  void
+  lookup_batch(const struct cb *cb,
+               unsigned int     n,
+               const uint64_t  *keys,
+               uint64_t        *values,
+               bool            *found) const
+  {
+    const struct structmap_amt_entry *entry[LOOKUP_BATCH_MAX];
+    unsigned int key_route_base = FIRSTLEVEL_BITS;
+    unsigned int pending = n;
+
+    assert(n <= LOOKUP_BATCH_MAX);
+
+    for (unsigned int i = 0; i < n; ++i) {
+      entry[i] = &(this->entries[keys[i] & ((1 << FIRSTLEVEL_BITS) - 1)]);
+      __builtin_prefetch(entry[i]);
+    }
+
+    while (pending > 0) {
+      for (unsigned int i = 0; i < n; ++i) {
+        if (!entry[i]) continue;
+
+        assert(entrytypeof(entry[i]) == STRUCTMAP_AMT_ENTRY_NODE || entrytypeof(entry[i]) == STRUCTMAP_AMT_ENTRY_EMPTY || entrytypeof(entry[i]) == STRUCTMAP_AMT_ENTRY_ITEM);
+        if (entrytypeof(entry[i]) == STRUCTMAP_AMT_ENTRY_NODE) {
+          const node *child_node = (node *)cb_at_immed(&thread_cb_at_immed_param, entryoffsetof(entry[i]));
+          unsigned int child_route = (keys[i] >> key_route_base) & ((1 << LEVEL_BITS) - 1);
+          entry[i] = &(child_node->entries[child_route]);
+          __builtin_prefetch(entry[i]);
+          continue;
+        }
+
+        found[i] = (entry[i]->key_offset_and_type == ((keys[i] << 2) | STRUCTMAP_AMT_ENTRY_ITEM));
+        if (found[i]) values[i] = entry[i]->value;
+        entry[i] = NULL;
+        --pending;
+      }
+
+      key_route_base += LEVEL_BITS;
+    }
+  }
+
   int
   insert(struct cb        **cb,
          struct cb_region  *region,
@@ -235,12 +334,45 @@ structmap_amt<FIRSTLEVEL_BITS, LEVEL_BITS>::init(structmap_value_size_t sizeof_v
   this->total_external_size = 0;
   this->sizeof_value = sizeof_value;
 
+  for (unsigned int i = 0; i < FIRSTLEVEL_OCCUPANCY_WORDS; ++i) {
+    this->firstlevel_occupancy[i] = 0;
+  }
+
   for (int i = 0; i < (1 << FIRSTLEVEL_BITS); ++i) {
     this->entries[i].key_offset_and_type = STRUCTMAP_AMT_ENTRY_EMPTY;
     this->entries[i].value = 0;
   }
 }
 
+template<unsigned int FIRSTLEVEL_BITS, unsigned int LEVEL_BITS>
+uint64_t
+structmap_amt<FIRSTLEVEL_BITS, LEVEL_BITS>::node_occupancy(const node *n)
+{
+  //NOTE: Returns a mask having bit i set iff n->entries[i] is not
+  // STRUCTMAP_AMT_ENTRY_EMPTY, computed without branching on each entry.
+  static_assert(LEVEL_BITS >= 1 && LEVEL_BITS <= 6, "node occupancy must fit a uint64_t");
+  uint64_t occupancy = 0;
+
+#if defined(__AVX2__)
+  // Each 256-bit load covers two entries; only the key_offset_and_type lanes
+  // (0 and 2) of the resulting comparison mask are of interest.
+  const __m256i typemask = _mm256_set1_epi64x(STRUCTMAP_AMT_TYPEMASK);
+  const __m256i empty    = _mm256_set1_epi64x(STRUCTMAP_AMT_ENTRY_EMPTY);
+  for (unsigned int i = 0; i < (1 << LEVEL_BITS); i += 2) {
+    __m256i pair = _mm256_load_si256((const __m256i *)&(n->entries[i]));
+    __m256i is_empty = _mm256_cmpeq_epi64(_mm256_and_si256(pair, typemask), empty);
+    unsigned int m = (unsigned int)_mm256_movemask_pd(_mm256_castsi256_pd(is_empty));
+    occupancy |= (uint64_t)(~((m & 0x1) | ((m >> 1) & 0x2)) & 0x3) << i;
+  }
+#else
+  for (unsigned int i = 0; i < (1 << LEVEL_BITS); ++i) {
+    occupancy |= (uint64_t)(entrytypeof(&(n->entries[i])) != STRUCTMAP_AMT_ENTRY_EMPTY) << i;
+  }
+#endif
+
+  return occupancy;
+}
+
 template<unsigned int FIRSTLEVEL_BITS, unsigned int LEVEL_BITS>
 int
 structmap_amt<FIRSTLEVEL_BITS, LEVEL_BITS>::node_alloc(struct cb        **cb,
@@ -321,9 +453,15 @@ structmap_amt<FIRSTLEVEL_BITS, LEVEL_BITS>::insert(struct cb        **cb,
   // that no CB resizes would happen.
   this->ensure_modification_size(cb, region);
 
-  struct structmap_amt_entry *entry = &(this->entries[key & ((1 << FIRSTLEVEL_BITS) - 1)]);
+  unsigned int firstlevel_route = key & ((1 << FIRSTLEVEL_BITS) - 1);
+  struct structmap_amt_entry *entry = &(this->entries[firstlevel_route]);
   unsigned int key_route_base = FIRSTLEVEL_BITS;
 
+  // Whichever of the cases below applies, the first-level entry ends up
+  // non-empty.
+  if (FIRSTLEVEL_OCCUPANCY_TRACKED)
+    this->firstlevel_occupancy[firstlevel_route / 64] |= ((uint64_t)1 << (firstlevel_route % 64));
+
   while (true) {
     switch (entrytypeof(entry)) {
       case STRUCTMAP_AMT_ENTRY_EMPTY:
@@ -458,28 +596,9 @@ structmap_amt<FIRSTLEVEL_BITS, LEVEL_BITS>::traverse_node(const struct cb
                                                           void                       *closure,
                                                           const node                 *n) const
 {
-  for (unsigned int i = 0; i < (1 << LEVEL_BITS); ++i) {
-    const struct structmap_amt_entry *entry = &(n->entries[i]);
-    switch (entrytypeof(entry)) {
-      case STRUCTMAP_AMT_ENTRY_NODE: {
-        const node *child_node = (node *)cb_at_immed(&thread_cb_at_immed_param, entryoffsetof(entry));
-        traverse_node(cb, func, closure, child_node);
-        break;
-      }
-
-      case STRUCTMAP_AMT_ENTRY_EMPTY:
-        continue;
-
-      case STRUCTMAP_AMT_ENTRY_ITEM:
-        func(entrykeyof(entry), entry->value, closure);
-        continue;
-
-#ifndef NDEBUG
-      default:
-        printf("Bogus structmap entry type: %d\n", entrytypeof(entry));
-        assert(false);
-#endif
-    }
+  for (uint64_t occupied = node_occupancy(n); occupied != 0; occupied &= occupied - 1) {
+    const struct structmap_amt_entry *entry = &(n->entries[__builtin_ctzll(occupied)]);
+    traverse_entry(cb, func, closure, entry);
   }
 
   return 0;
@@ -491,27 +610,19 @@ structmap_amt<FIRSTLEVEL_BITS, LEVEL_BITS>::traverse(const struct cb           *
                                                      structmap_traverse_func_t   func,
                                                      void                       *closure) const
 {
-  for (unsigned int i = 0; i < (1 << FIRSTLEVEL_BITS); ++i) {
-    const struct structmap_amt_entry *entry = &(this->entries[i]);
-    switch (entrytypeof(entry)) {
-      case STRUCTMAP_AMT_ENTRY_NODE: {
-        const node *child_node = (node *)cb_at_immed(&thread_cb_at_immed_param, entryoffsetof(entry));
-        traverse_node(cb, func, closure, child_node);
-        break;
-      }
-
-      case STRUCTMAP_AMT_ENTRY_EMPTY:
-        continue;
-
-      case STRUCTMAP_AMT_ENTRY_ITEM:
-        func(entrykeyof(entry), entry->value, closure);
-        continue;
+  if (!FIRSTLEVEL_OCCUPANCY_TRACKED) {
+    for (unsigned int i = 0; i < (1 << FIRSTLEVEL_BITS); ++i) {
+      const struct structmap_amt_entry *entry = &(this->entries[i]);
+      if (entrytypeof(entry) != STRUCTMAP_AMT_ENTRY_EMPTY)
+        traverse_entry(cb, func, closure, entry);
+    }
+    return 0;
+  }
 
-#ifndef NDEBUG
-      default:
-        printf("Bogus structmap entry type: %d\n", entrytypeof(entry));
-        assert(false);
-#endif
+  for (unsigned int w = 0; w < FIRSTLEVEL_OCCUPANCY_WORDS; ++w) {
+    for (uint64_t occupied = this->firstlevel_occupancy[w]; occupied != 0; occupied &= occupied - 1) {
+      const struct structmap_amt_entry *entry = &(this->entries[w * 64 + __builtin_ctzll(occupied)]);
+      traverse_entry(cb, func, closure, entry);
     }
   }
 
@@ -1,4 +1,6 @@
 #include <assert.h>
+#include <limits.h>
+#include <math.h>
 #include <stdarg.h>
 #include <stdio.h>
 #include <string.h>
@@ -10,6 +12,8 @@
 #include "common.h"
 #include "compiler.h"
 #include "debug.h"
+#include "f64array.h"
+#include "hashmap.h"
 #include "object.h"
 #include "memory.h"
 #include "vm.h"
@@ -20,7 +24,7 @@
 static struct {
   uint64_t count;
   uint64_t total_lat;
-} lats[OP_METHOD+1];
+} lats[OP_SET_INDEX+1];
 
 #endif //KLOX_ILAT
 
@@ -35,10 +39,11 @@ tristack_reset(TriStack *ts) {
                            &thread_region,
                            &new_offset,
                            cb_alignof(Value),
-                           sizeof(Value) * STACK_MAX);
+                           sizeof(Value) * TRISTACK_MIN_CAPACITY);
   assert(ret == 0);
 
   ts->abo = new_offset;
+  ts->acapacity = TRISTACK_MIN_CAPACITY;
   ts->abi = 0;
   ts->adirect = (Value*)cb_at_immed(&thread_cb_at_immed_param, new_offset);
   ts->bbo = CB_NULL;
@@ -56,22 +61,95 @@ void tristack_recache(TriStack *ts, struct cb *target_cb) {
   ts->cdirect = (ts->cbo == CB_NULL ? 0 : (Value*)cb_at(target_cb, ts->cbo));
 }
 
-static Value*
-tristack_at_bc(TriStack *ts, unsigned int index) {
-  assert(index < ts->stackDepth);
-  //CBINT FIXME - add a way to check maximum index of B subsection?
+// Ensures that the A section can hold at least 'acapacity' Values (counting
+// from abi), moving it to a larger array if need be.
+//NOTE: Only the A section is moved, as B and C are never grown.  The abandoned
+// array is reclaimed along with the rest of the region by a later collection.
+static void
+tristack_reserve(TriStack *ts, unsigned int acapacity) {
+  cb_offset_t new_offset;
+  int ret;
 
-  if (index >= ts->bbi) {
-    Value *retval = &(ts->bdirect[index - ts->bbi]);
-    assert(is_resizing || ts->bdirect == static_cast<Value*>(cb_at(thread_cb, ts->bbo)));
-    assert(is_resizing || retval == static_cast<Value*>(cb_at(thread_cb, ts->bbo + (index - ts->bbi) * sizeof(Value))));
-    return retval;
-  } else {
-    Value *retval = &(ts->cdirect[index - ts->cbi]);
-    assert(is_resizing || ts->cdirect == static_cast<Value*>(cb_at(thread_cb, ts->cbo)));
-    assert(is_resizing || retval == static_cast<Value*>(cb_at(thread_cb, ts->cbo + (index - ts->cbi) * sizeof(Value))));
-    return retval;
+  (void)ret;
+
+  if (__builtin_expect(!!(acapacity <= ts->acapacity), 1))
+    return;
+
+  unsigned int newCapacity = ts->acapacity * 2;
+  if (newCapacity < acapacity) newCapacity = acapacity;
+
+  ret = cb_region_memalign(&thread_cb,
+                           &thread_region,
+                           &new_offset,
+                           cb_alignof(Value),
+                           sizeof(Value) * newCapacity);
+  assert(ret == 0);
+
+  //NOTE: The allocation may have resized the continuous buffer, so the source
+  // is re-derived here rather than taken from the cached adirect.
+  memcpy(cb_at(thread_cb, new_offset),
+         cb_at(thread_cb, ts->abo),
+         (ts->stackDepth - ts->abi) * sizeof(Value));
+
+  ts->abo = new_offset;
+  ts->acapacity = newCapacity;
+  tristack_recache(ts, thread_cb);
+}
+
+void
+tristack_grow(TriStack *ts) {
+  tristack_reserve(ts, ts->stackDepth - ts->abi + 1);
+
+  //NOTE: The current frame's slots may have moved along with the A section.
+  if (ts == &(vm.tristack) && vm.currentFrame)
+    vm.currentFrame->slots = tristack_at(ts, vm.currentFrame->slotsIndex);
+}
+
+// Lowers abi to newAbi, bringing the values at [newAbi, abi) into the mutable
+// A section.
+//NOTE: The A section is indexed relative to abi, so any values already in A
+// slide up to make room.  Those brought from B and C are copied wholesale, as
+// each of those sections is itself contiguous.
+static void
+tristack_lowerAbi(TriStack *ts, unsigned int newAbi) {
+  assert(newAbi < ts->abi);
+  assert(ts->abi <= ts->stackDepth);
+  assert(ts->bbi <= ts->abi);
+  assert(ts->adirect == static_cast<Value*>(cb_at(thread_cb, ts->abo)));
+
+  tristack_reserve(ts, ts->stackDepth - newAbi);
+
+  unsigned int shift = ts->abi - newAbi;
+
+  if (ts->stackDepth > ts->abi)
+    memmove(ts->adirect + shift, ts->adirect, (ts->stackDepth - ts->abi) * sizeof(Value));
+
+  unsigned int bStart = (newAbi > ts->bbi ? newAbi : ts->bbi);
+  if (ts->abi > bStart) {
+    assert(ts->bdirect == static_cast<Value*>(cb_at(thread_cb, ts->bbo)));
+    memcpy(ts->adirect + (bStart - newAbi),
+           ts->bdirect + (bStart - ts->bbi),
+           (ts->abi - bStart) * sizeof(Value));
+  }
+
+  if (newAbi < ts->bbi) {
+    assert(ts->cdirect == static_cast<Value*>(cb_at(thread_cb, ts->cbo)));
+    memcpy(ts->adirect,
+           ts->cdirect + (newAbi - ts->cbi),
+           (ts->bbi - newAbi) * sizeof(Value));
   }
+
+  ts->abi = newAbi;
+}
+
+// Whether a direct pointer derived from a cached array pointer corresponds to
+// the given offset.
+//NOTE: An array may straddle the end of the ring, in which case pointers to
+// its later elements run on into the ring's second mapping.
+static bool
+tristack_directMatches(const Value *p, cb_offset_t offset) {
+  const char *q = static_cast<const char*>(cb_at(thread_cb, offset));
+  return (const char*)p == q || (const char*)p == q + cb_ring_size(thread_cb);
 }
 
 Value*
@@ -84,17 +162,17 @@ tristack_at(TriStack *ts, unsigned int index) {
   if (index >= ts->abi) {
     Value *retval = &(ts->adirect[index - ts->abi]);
     assert(is_resizing || ts->adirect == static_cast<Value*>(cb_at(thread_cb, ts->abo)));
-    assert(is_resizing || retval == static_cast<Value*>(cb_at(thread_cb, ts->abo + (index - ts->abi) * sizeof(Value))));
+    assert(is_resizing || tristack_directMatches(retval, ts->abo + (index - ts->abi) * sizeof(Value)));
     return retval;
   } else if (index >= ts->bbi) {
     Value *retval = &(ts->bdirect[index - ts->bbi]);
     assert(is_resizing || ts->bdirect == static_cast<Value*>(cb_at(thread_cb, ts->bbo)));
-    assert(is_resizing || retval == static_cast<Value*>(cb_at(thread_cb, ts->bbo + (index - ts->bbi) * sizeof(Value))));
+    assert(is_resizing || tristack_directMatches(retval, ts->bbo + (index - ts->bbi) * sizeof(Value)));
     return retval;
   } else {
     Value *retval = &(ts->cdirect[index - ts->cbi]);
     assert(is_resizing || ts->cdirect == static_cast<Value*>(cb_at(thread_cb, ts->cbo)));
-    assert(is_resizing || retval == static_cast<Value*>(cb_at(thread_cb, ts->cbo + (index - ts->cbi) * sizeof(Value))));
+    assert(is_resizing || tristack_directMatches(retval, ts->cbo + (index - ts->cbi) * sizeof(Value)));
     return retval;
   }
 }
@@ -128,10 +206,11 @@ triframes_reset(TriFrames *tf) {
                            &thread_region,
                            &new_offset,
                            cb_alignof(CallFrame),
-                           sizeof(CallFrame) * FRAMES_MAX);
+                           sizeof(CallFrame) * TRIFRAMES_MIN_CAPACITY);
   assert(ret == 0);
 
   tf->abo = new_offset;
+  tf->acapacity = TRIFRAMES_MIN_CAPACITY;
   tf->abi = 0;
   tf->adirect = (CallFrame*)cb_at_immed(&thread_cb_at_immed_param, new_offset);
   tf->bbo = CB_NULL;
@@ -162,9 +241,50 @@ void triframes_recache(TriFrames *tf, struct cb *target_cb) {
   }
 }
 
+// Ensures that the A section can hold at least 'acapacity' CallFrames
+// (counting from abi), moving it to a larger array if need be.
+static void
+triframes_reserve(TriFrames *tf, unsigned int acapacity) {
+  cb_offset_t new_offset;
+  int ret;
+
+  (void)ret;
+
+  if (__builtin_expect(!!(acapacity <= tf->acapacity), 1))
+    return;
+
+  unsigned int newCapacity = tf->acapacity * 2;
+  if (newCapacity < acapacity) newCapacity = acapacity;
+
+  ret = cb_region_memalign(&thread_cb,
+                           &thread_region,
+                           &new_offset,
+                           cb_alignof(CallFrame),
+                           sizeof(CallFrame) * newCapacity);
+  assert(ret == 0);
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wclass-memaccess"
+  memcpy(cb_at(thread_cb, new_offset),
+         cb_at(thread_cb, tf->abo),
+         (tf->frameCount - tf->abi) * sizeof(CallFrame));
+#pragma GCC diagnostic pop
+
+  tf->abo = new_offset;
+  tf->acapacity = newCapacity;
+  if (tf->frameCount > 0) {
+    triframes_recache(tf, thread_cb);
+  } else {
+    tf->adirect = (CallFrame*)cb_at(thread_cb, tf->abo);
+  }
+  assert(on_main_thread);
+  vm.currentFrame = tf->currentFrame;
+}
+
 extern inline void
 triframes_enterFrame(TriFrames *tf) {
   assert(tf->frameCount >= tf->abi);
+  assert(tf->frameCount - tf->abi < tf->acapacity);
 
   assert(tf->adirect == static_cast<CallFrame*>(cb_at(thread_cb, tf->abo)));
   tf->currentFrame = &(tf->adirect[tf->frameCount - tf->abi]);
@@ -237,13 +357,8 @@ fixup_slots:
     vm.currentFrame->gc_integration_epoch = gc_integration_epoch;
   }
 
-  if (vm.currentFrame->slotsIndex < vm.tristack.abi) {
-    Value *mutableRange = tristack_at(&(vm.tristack), vm.tristack.abi);
-    for (int i = vm.tristack.stackDepth, e = vm.currentFrame->slotsIndex; i > e; i--) {
-      mutableRange[(i-1) - vm.currentFrame->slotsIndex] = *tristack_at(&(vm.tristack), i-1);
-    }
-    vm.tristack.abi = vm.currentFrame->slotsIndex;
-  }
+  if (vm.currentFrame->slotsIndex < vm.tristack.abi)
+    tristack_lowerAbi(&(vm.tristack), vm.currentFrame->slotsIndex);
   vm.currentFrame->slots = tristack_at(&(vm.tristack), vm.currentFrame->slotsIndex);
 }
 
@@ -326,10 +441,251 @@ triframes_print(TriFrames *tf) {
 VM vm;
 GC gc;
 
+// Natives cannot call runtimeError() directly, as the native's arguments are
+// still on the stack.  Instead they record a message via nativeError() and
+// callValue() raises it once the native has returned.
+static bool nativeErrorPending = false;
+static char nativeErrorMessage[256];
+
+static Value nativeError(const char* format, ...) {
+  va_list args;
+  va_start(args, format);
+  vsnprintf(nativeErrorMessage, sizeof(nativeErrorMessage), format, args);
+  va_end(args);
+  nativeErrorPending = true;
+  return NIL_VAL;
+}
+
+static void listAppend(OID<ObjList> list, Value value) {
+  PIN_SCOPE;
+  const ObjList *clist = list.clip().cp();
+
+  int newCapacity = clist->capacity;
+  CBO<Value> newValues;
+  bool hasNewArray = false;
+
+  if (clist->capacity < clist->count + 1) {
+    int oldCapacity = clist->capacity;
+    newCapacity = GROW_CAPACITY(oldCapacity);
+
+    //NOTE: A fresh array is allocated rather than growing the existing one in
+    // place, as the existing one may belong to a B or C layer of this list
+    // which must not be disturbed.
+    newValues = ALLOCATE(Value, newCapacity);
+    clist = list.clip().cp();  //re-derive, allocation may have provoked a GC
+    memcpy(newValues.mlp().mp(), clist->values.clp().cp(), clist->count * sizeof(Value));
+    hasNewArray = true;
+  }
+
+  ObjList *mlist = list.mlip().mp();  //cb-resize-safe (no allocations in lifetime)
+
+  if (hasNewArray) {
+    //NOTE: Because this values extension is done to a list already present
+    // in the objtable, we must manually inform the objtable of this
+    // independent mutation of external size.  This is only done once the
+    // mutable layer has been derived, as deriving it may provoke a GC, which
+    // would freeze the adjusted A layer without the list in it.
+    objtable_external_size_adjust_A(&thread_objtable,
+                                    (newCapacity - mlist->capacity) * sizeof(Value));
+  }
+
+  mlist->capacity = newCapacity;
+  if (hasNewArray)
+    mlist->values = newValues;
+  mlist->values.mlp().mp()[mlist->count] = value;
+  mlist->count++;
+}
+
 static Value clockNative(int argCount, Value* args) {
   return NUMBER_VAL((double)clock() / CLOCKS_PER_SEC);
 }
 
+static Value lenNative(int argCount, Value* args) {
+  if (argCount != 1) return nativeError("Expected 1 arguments but got %d.", argCount);
+
+  if (IS_LIST(args[0])) return NUMBER_VAL(AS_LIST_OID(args[0]).clip().cp()->count);
+  if (IS_MAP(args[0])) return NUMBER_VAL(AS_MAP_OID(args[0]).clip().cp()->count);
+  if (IS_HASHMAP(args[0])) return NUMBER_VAL(AS_HASHMAP_OID(args[0]).clip().cp()->count);
+  if (IS_F64ARRAY(args[0])) return NUMBER_VAL(AS_F64ARRAY_OID(args[0]).clip().cp()->count);
+  if (IS_STRING(args[0])) return NUMBER_VAL(AS_STRING_OID(args[0]).clip().cp()->length);
+
+  return nativeError("Argument to len() must be a list, map, hash map, f64 array, or string.");
+}
+
+static Value appendNative(int argCount, Value* args) {
+  if (argCount != 2) return nativeError("Expected 2 arguments but got %d.", argCount);
+  if (!IS_LIST(args[0])) return nativeError("Can only append to a list.");
+
+  //NOTE: 'args' must not be used after this, as appending may allocate.
+  listAppend(AS_LIST_OID(args[0]), args[1]);
+  return NIL_VAL;
+}
+
+static Value mapNative(int argCount, Value* args) {
+  if (argCount != 0) return nativeError("Expected 0 arguments but got %d.", argCount);
+
+  return OBJ_VAL(newMap().id());
+}
+
+static Value mapGetNative(int argCount, Value* args) {
+  if (argCount != 2) return nativeError("Expected 2 arguments but got %d.", argCount);
+  if (!IS_MAP(args[0])) return nativeError("Argument to mapGet() must be a map.");
+
+  Value value;
+  if (!mapGet(AS_MAP_OID(args[0]), args[1], &value)) return NIL_VAL;
+  return value;
+}
+
+static Value mapHasNative(int argCount, Value* args) {
+  if (argCount != 2) return nativeError("Expected 2 arguments but got %d.", argCount);
+  if (!IS_MAP(args[0])) return nativeError("Argument to mapHas() must be a map.");
+
+  Value value;
+  return BOOL_VAL(mapGet(AS_MAP_OID(args[0]), args[1], &value));
+}
+
+static Value mapSetNative(int argCount, Value* args) {
+  if (argCount != 3) return nativeError("Expected 3 arguments but got %d.", argCount);
+  if (!IS_MAP(args[0])) return nativeError("Argument to mapSet() must be a map.");
+
+  //NOTE: 'args' must not be used after this, as deriving the new map may allocate.
+  return OBJ_VAL(mapSet(AS_MAP_OID(args[0]), args[1], args[2]).id());
+}
+
+static Value mapRemoveNative(int argCount, Value* args) {
+  if (argCount != 2) return nativeError("Expected 2 arguments but got %d.", argCount);
+  if (!IS_MAP(args[0])) return nativeError("Argument to mapRemove() must be a map.");
+
+  //NOTE: 'args' must not be used after this, as deriving the new map may allocate.
+  return OBJ_VAL(mapRemove(AS_MAP_OID(args[0]), args[1]).id());
+}
+
+static Value hashMapNative(int argCount, Value* args) {
+  if (argCount != 0) return nativeError("Expected 0 arguments but got %d.", argCount);
+
+  return OBJ_VAL(newHashMap().id());
+}
+
+static Value hashMapHasNative(int argCount, Value* args) {
+  if (argCount != 2) return nativeError("Expected 2 arguments but got %d.", argCount);
+  if (!IS_HASHMAP(args[0])) return nativeError("Argument to hashMapHas() must be a hash map.");
+
+  Value value;
+  return BOOL_VAL(hashMapGet(AS_HASHMAP_OID(args[0]), args[1], &value));
+}
+
+static Value hashMapRemoveNative(int argCount, Value* args) {
+  if (argCount != 2) return nativeError("Expected 2 arguments but got %d.", argCount);
+  if (!IS_HASHMAP(args[0])) return nativeError("Argument to hashMapRemove() must be a hash map.");
+
+  return BOOL_VAL(hashMapDelete(AS_HASHMAP_OID(args[0]), args[1]));
+}
+
+static Value f64ArrayNative(int argCount, Value* args) {
+  if (argCount != 1) return nativeError("Expected 1 arguments but got %d.", argCount);
+
+  if (IS_NUMBER(args[0])) {
+    double d = AS_NUMBER(args[0]);
+    if (d < 0 || d != floor(d) || d > INT_MAX)
+      return nativeError("F64Array() length must be a non-negative integer.");
+    return OBJ_VAL(newF64Array((int)d).id());
+  }
+
+  if (!IS_LIST(args[0])) return nativeError("Argument to F64Array() must be a length or a list of numbers.");
+
+  OID<ObjList> list = AS_LIST_OID(args[0]);
+  int count = list.clip().cp()->count;
+  const Value *values = list.clip().cp()->values.clp().cp();
+  for (int i = 0; i < count; ++i) {
+    if (!IS_NUMBER(values[i])) return nativeError("Argument to F64Array() must be a length or a list of numbers.");
+  }
+
+  //NOTE: 'args' must not be used after this, as creating the array allocates.
+  OID<ObjF64Array> array = newF64Array(count);
+  double *dest = array.mlip().mp()->values.mlp().mp();  //cb-resize-safe (no allocations in lifetime)
+  values = list.clip().cp()->values.clp().cp();
+  for (int i = 0; i < count; ++i) dest[i] = AS_NUMBER(values[i]);
+  return OBJ_VAL(array.id());
+}
+
+static Value f64SumNative(int argCount, Value* args) {
+  if (argCount != 1) return nativeError("Expected 1 arguments but got %d.", argCount);
+  if (!IS_F64ARRAY(args[0])) return nativeError("Argument to f64Sum() must be an f64 array.");
+
+  const ObjF64Array *a = AS_F64ARRAY_OID(args[0]).clip().cp();
+  return NUMBER_VAL(f64ArraySum(a->values.clp().cp(), a->count));
+}
+
+static Value f64DotNative(int argCount, Value* args) {
+  if (argCount != 2) return nativeError("Expected 2 arguments but got %d.", argCount);
+  if (!IS_F64ARRAY(args[0]) || !IS_F64ARRAY(args[1])) return nativeError("Arguments to f64Dot() must be f64 arrays.");
+
+  const ObjF64Array *a = AS_F64ARRAY_OID(args[0]).clip().cp();
+  const ObjF64Array *b = AS_F64ARRAY_OID(args[1]).clip().cp();
+  if (a->count != b->count) return nativeError("Arguments to f64Dot() must have the same length.");
+  return NUMBER_VAL(f64ArrayDot(a->values.clp().cp(), b->values.clp().cp(), a->count));
+}
+
+static Value f64AxpyNative(int argCount, Value* args) {
+  if (argCount != 3) return nativeError("Expected 3 arguments but got %d.", argCount);
+  if (!IS_NUMBER(args[0]) || !IS_F64ARRAY(args[1]) || !IS_F64ARRAY(args[2]))
+    return nativeError("Arguments to f64Axpy() must be a number and two f64 arrays.");
+
+  double alpha = AS_NUMBER(args[0]);
+  OID<ObjF64Array> x = AS_F64ARRAY_OID(args[1]);
+  OID<ObjF64Array> y = AS_F64ARRAY_OID(args[2]);
+  int count = y.clip().cp()->count;
+  if (x.clip().cp()->count != count) return nativeError("Arguments to f64Axpy() must have the same length.");
+
+  //NOTE: 'args' must not be used after this, as mlip() may allocate.  'x' is
+  // only read afterward so that it reflects 'y' if they are the same array.
+  double *dest = y.mlip().mp()->values.mlp().mp();  //cb-resize-safe (no allocations in lifetime)
+  f64ArrayAxpy(alpha, x.clip().cp()->values.clp().cp(), dest, count);
+  return NIL_VAL;
+}
+
+static Value f64ScaleNative(int argCount, Value* args) {
+  if (argCount != 2) return nativeError("Expected 2 arguments but got %d.", argCount);
+  if (!IS_F64ARRAY(args[0]) || !IS_NUMBER(args[1]))
+    return nativeError("Arguments to f64Scale() must be an f64 array and a number.");
+
+  OID<ObjF64Array> a = AS_F64ARRAY_OID(args[0]);
+  double s = AS_NUMBER(args[1]);
+
+  //NOTE: 'args' must not be used after this, as mlip() may allocate.
+  ObjF64Array *ma = a.mlip().mp();
+  f64ArrayScale(ma->values.mlp().mp(), s, ma->count);
+  return NIL_VAL;
+}
+
+static Value f64MinNative(int argCount, Value* args) {
+  if (argCount != 1) return nativeError("Expected 1 arguments but got %d.", argCount);
+  if (!IS_F64ARRAY(args[0])) return nativeError("Argument to f64Min() must be an f64 array.");
+
+  const ObjF64Array *a = AS_F64ARRAY_OID(args[0]).clip().cp();
+  if (a->count == 0) return NIL_VAL;
+  return NUMBER_VAL(f64ArrayMin(a->values.clp().cp(), a->count));
+}
+
+static Value f64MaxNative(int argCount, Value* args) {
+  if (argCount != 1) return nativeError("Expected 1 arguments but got %d.", argCount);
+  if (!IS_F64ARRAY(args[0])) return nativeError("Argument to f64Max() must be an f64 array.");
+
+  const ObjF64Array *a = AS_F64ARRAY_OID(args[0]).clip().cp();
+  if (a->count == 0) return NIL_VAL;
+  return NUMBER_VAL(f64ArrayMax(a->values.clp().cp(), a->count));
+}
+
+static Value f64SortNative(int argCount, Value* args) {
+  if (argCount != 1) return nativeError("Expected 1 arguments but got %d.", argCount);
+  if (!IS_F64ARRAY(args[0])) return nativeError("Argument to f64Sort() must be an f64 array.");
+
+  //NOTE: 'args' must not be used after this, as mlip() may allocate.
+  ObjF64Array *ma = AS_F64ARRAY_OID(args[0]).mlip().mp();
+  f64ArraySort(ma->values.mlp().mp(), ma->count);
+  return NIL_VAL;
+}
+
 static void resetStack() {
   tristack_reset(&(vm.tristack));
   triframes_reset(&(vm.triframes));
@@ -398,6 +754,24 @@ void initVM() {
   vm.initString = copyString("init", 4);
 
   defineNative("clock", clockNative);
+  defineNative("len", lenNative);
+  defineNative("append", appendNative);
+  defineNative("Map", mapNative);
+  defineNative("mapGet", mapGetNative);
+  defineNative("mapHas", mapHasNative);
+  defineNative("mapSet", mapSetNative);
+  defineNative("mapRemove", mapRemoveNative);
+  defineNative("HashMap", hashMapNative);
+  defineNative("hashMapHas", hashMapHasNative);
+  defineNative("hashMapRemove", hashMapRemoveNative);
+  defineNative("F64Array", f64ArrayNative);
+  defineNative("f64Sum", f64SumNative);
+  defineNative("f64Dot", f64DotNative);
+  defineNative("f64Axpy", f64AxpyNative);
+  defineNative("f64Scale", f64ScaleNative);
+  defineNative("f64Min", f64MinNative);
+  defineNative("f64Max", f64MaxNative);
+  defineNative("f64Sort", f64SortNative);
 }
 
 void freeVM() {
@@ -425,6 +799,11 @@ static bool call(OID<ObjClosure> closure, int argCount) {
     return false;
   }
 
+  //NOTE: Both of these may move the A sections, leaving stale the 'slots' of
+  // the calling frame.  That is re-derived upon returning to it.
+  triframes_reserve(&(vm.triframes), vm.triframes.frameCount + 1 - vm.triframes.abi);
+  tristack_reserve(&(vm.tristack), vm.tristack.stackDepth - argCount - 1 + FRAME_STACK_HEADROOM - vm.tristack.abi);
+
   triframes_enterFrame(&(vm.triframes));
   frame = triframes_currentFrame(&(vm.triframes));
   frame->closure = closure;
@@ -689,6 +1068,11 @@ static bool callValue(Value callee, int argCount) {
         Value* loc = tristack_at(&(vm.tristack), vm.tristack.stackDepth - argCount);
         assert(loc >= cb_at(thread_cb, vm.tristack.abo));
         Value result = native(argCount, loc);
+        if (nativeErrorPending) {
+          nativeErrorPending = false;
+          runtimeError("%s", nativeErrorMessage);
+          return false;
+        }
         tristack_discardn(&(vm.tristack), argCount + 1);
         push(result);
         return true;
@@ -847,6 +1231,31 @@ static void closeUpvalues(unsigned int lastStackIndex) {
   }
 }
 
+static bool checkIndex(const char *kind, int count, Value indexValue, int *index) {
+  if (!IS_NUMBER(indexValue)) {
+    runtimeError("%s index must be a number.", kind);
+    return false;
+  }
+
+  double d = AS_NUMBER(indexValue);
+  if (d != floor(d)) {
+    runtimeError("%s index must be an integer.", kind);
+    return false;
+  }
+
+  if (d < 0 || d >= count) {
+    runtimeError("%s index out of range.", kind);
+    return false;
+  }
+
+  *index = (int)d;
+  return true;
+}
+
+static bool checkListIndex(OID<ObjList> list, Value indexValue, int *index) {
+  return checkIndex("List", list.clip().cp()->count, indexValue, index);
+}
+
 static void defineMethod(Value name) {
   assert(IS_STRING(name));
   Value method = peek(0);
@@ -1213,33 +1622,27 @@ static InterpretResult run() {
         // we have recently performed a GC, so we cannot do the following:
         //assert(frame->slotsIndex >= vm.tristack.abi);
 
+        // Shorten the stack to whatever was its depth prior to entering the
+        // frame we are returning from.
+        //NOTE: This is done before leaving the frame so that, should the
+        // returned-to frame's slots need bringing into the mutable A region,
+        // only those slots are copied and not also the dead ones of this frame.
+        tristack_discardn(&(vm.tristack), vm.tristack.stackDepth - oldFrameSlotsIndex);
+
+        //NOTE: If we return to a frame whose slotsIndex is at a lower index
+        // than where abi begins (such that it is not in the mutable A region),
+        // leaving the frame will move the contents of this returned-to frame
+        // into the mutable section A and shift abi to reflect that this portion
+        // of the stack indexes is now mutable.  This maintains the invariant
+        // that the present frame's portion of the stack is always contiguous in
+        // the mutable section A.
         triframes_leaveFrame(&(vm.triframes));  // NOTE: does not yet update our local variable 'frame'.
         if (triframes_frameCount(&(vm.triframes)) == 0) {
-          pop();
           return INTERPRET_OK;
         }
 
-        //NOTE: The purpose of this section is to move "up" (read: lower in
-        // index) the stack. If we've returned to a frame whose slotsIndex is at
-        // a lower index than where abi begins (such that it is not in the
-        // mutable A region), we must move the contents of this returned-to
-        // frame into the mutable section A and shift abi to reflect that this
-        // portion of the stack indexes is now mutable.  This will maintain the
-        // invariant that the present frame's portion of the stack is always
-        // contiguous in the mutable section A.
         vm.currentFrame = triframes_currentFrame(&(vm.triframes));
-        if (vm.currentFrame->slotsIndex < vm.tristack.abi) {
-          vm.tristack.abi = vm.currentFrame->slotsIndex;
-          memcpy(tristack_at(&(vm.tristack), vm.tristack.abi),
-                 tristack_at_bc(&(vm.tristack), vm.currentFrame->slotsIndex),
-                 (oldFrameSlotsIndex - vm.currentFrame->slotsIndex) * sizeof(Value));
-          vm.currentFrame->slots = tristack_at(&(vm.tristack), vm.currentFrame->slotsIndex);  //re-derive pointer
-          //FIXME update adirect
-        }
-
-        // Shorten the stack to whatever was its depth prior to entering the
-        // frame we have now returned from.
-        vm.tristack.stackDepth = oldFrameSlotsIndex;
+        assert(vm.tristack.stackDepth == oldFrameSlotsIndex);
         assert(vm.currentFrame->slots == tristack_at(&(vm.tristack), vm.currentFrame->slotsIndex));
         assert(vm.currentFrame->slots >= cb_at(thread_cb, vm.tristack.abo));  //Slots must be contiguous, and in mutable section A.
         assert(vm.currentFrame->slotsIndex >= vm.tristack.abi);
@@ -1268,11 +1671,135 @@ static InterpretResult run() {
         break;
       }
 
-      case OP_METHOD:
+      case OP_METHOD: {
         Value name = READ_CONSTANT();
         assert(IS_STRING(name));
         defineMethod(name);
         break;
+      }
+
+      case OP_BUILD_LIST: {
+        uint8_t itemCount = READ_BYTE();
+        OID<ObjList> list = newList(itemCount);
+
+        // The items are still on the stack (and so still rooted) up until
+        // this point, so they are copied out only once allocation is done.
+        ObjList *mlist = list.mlip().mp();  //cb-resize-safe (no allocations in lifetime)
+        Value *values = mlist->values.mlp().mp();
+        for (int i = 0; i < itemCount; i++) {
+          values[i] = peek(itemCount - 1 - i);
+        }
+        mlist->count = itemCount;
+
+        tristack_discardn(&(vm.tristack), itemCount);
+        push(OBJ_VAL(list.id()));
+        break;
+      }
+
+      case OP_GET_INDEX: {
+        if (IS_HASHMAP(peek(1))) {
+          Value value;
+          if (!hashMapGet(AS_HASHMAP_OID(peek(1)), peek(0), &value)) value = NIL_VAL;
+          pop(); // Key.
+          pop(); // Hash map.
+          push(value);
+          break;
+        }
+
+        if (IS_F64ARRAY(peek(1))) {
+          OID<ObjF64Array> array = AS_F64ARRAY_OID(peek(1));
+          int index;
+          if (!checkIndex("Array", array.clip().cp()->count, peek(0), &index)) {
+            return INTERPRET_RUNTIME_ERROR;
+          }
+
+          double d = array.clip().cp()->values.clp().cp()[index];
+          pop(); // Index.
+          pop(); // Array.
+          push(NUMBER_VAL(d));
+          break;
+        }
+
+        if (!IS_LIST(peek(1))) {
+          runtimeError("Only lists, hash maps, and f64 arrays can be indexed.");
+          return INTERPRET_RUNTIME_ERROR;
+        }
+
+        OID<ObjList> list = AS_LIST_OID(peek(1));
+        int index;
+        if (!checkListIndex(list, peek(0), &index)) {
+          return INTERPRET_RUNTIME_ERROR;
+        }
+
+        Value value = list.clip().cp()->values.clp().cp()[index];
+        pop(); // Index.
+        pop(); // List.
+        push(value);
+        break;
+      }
+
+      case OP_SET_INDEX: {
+        if (IS_HASHMAP(peek(2))) {
+          if (IS_NIL(peek(1))) {
+            runtimeError("Hash map key cannot be nil.");
+            return INTERPRET_RUNTIME_ERROR;
+          }
+
+          //NOTE: The key and value remain on the stack (and so remain rooted)
+          // across any allocation made while inserting.
+          hashMapSet(AS_HASHMAP_OID(peek(2)), peek(1), peek(0));
+          Value value = pop();
+          pop(); // Key.
+          pop(); // Hash map.
+          push(value);
+          break;
+        }
+
+        if (IS_F64ARRAY(peek(2))) {
+          OID<ObjF64Array> array = AS_F64ARRAY_OID(peek(2));
+          int index;
+          if (!checkIndex("Array", array.clip().cp()->count, peek(1), &index)) {
+            return INTERPRET_RUNTIME_ERROR;
+          }
+
+          if (!IS_NUMBER(peek(0))) {
+            runtimeError("Array element must be a number.");
+            return INTERPRET_RUNTIME_ERROR;
+          }
+
+          //NOTE: mlip() may allocate a mutable A-layer copy of the array, so
+          // the pointer is taken only once it has returned.
+          ObjF64Array *mutableArray = array.mlip().mp();  //cb-resize-safe (no allocations in lifetime)
+          mutableArray->values.mlp().mp()[index] = AS_NUMBER(peek(0));
+          Value value = pop();
+          pop(); // Index.
+          pop(); // Array.
+          push(value);
+          break;
+        }
+
+        if (!IS_LIST(peek(2))) {
+          runtimeError("Only lists, hash maps, and f64 arrays can be indexed.");
+          return INTERPRET_RUNTIME_ERROR;
+        }
+
+        OID<ObjList> list = AS_LIST_OID(peek(2));
+        int index;
+        if (!checkListIndex(list, peek(1), &index)) {
+          return INTERPRET_RUNTIME_ERROR;
+        }
+
+        //NOTE: mlip() will first derive a mutable A-layer copy of the list if
+        // it presently resides in B or C (copy-on-write).  That allocates, so
+        // the pointer is taken only once it has returned.
+        ObjList *mutableList = list.mlip().mp();  //cb-resize-safe (no allocations in lifetime)
+        mutableList->values.mlp().mp()[index] = peek(0);
+        Value value = pop();
+        pop(); // Index.
+        pop(); // List.
+        push(value);
+        break;
+      }
     }
 
 #if KLOX_ILAT
@@ -1313,7 +1840,7 @@ InterpretResult interpret(const char* source) {
 
 #if KLOX_ILAT
   uint64_t total_lat = 0;
-  for (int i = 0; i < OP_METHOD+1; ++i) { total_lat += lats[i].total_lat; }
+  for (int i = 0; i < OP_SET_INDEX+1; ++i) { total_lat += lats[i].total_lat; }
 
   FILE *ilatf = fopen("ilat.out", "a");
   fprintf(ilatf, "#\n");
@@ -1366,6 +1893,9 @@ InterpretResult interpret(const char* source) {
   PRINTIT(OP_CLASS);
   PRINTIT(OP_INHERIT);
   PRINTIT(OP_METHOD);
+  PRINTIT(OP_BUILD_LIST);
+  PRINTIT(OP_GET_INDEX);
+  PRINTIT(OP_SET_INDEX);
 
 #undef PRINTIT
   fclose(ilatf);
@@ -5,8 +5,19 @@
 #include "table.h"
 #include "value.h"
 
-#define FRAMES_MAX 64
-#define STACK_MAX (FRAMES_MAX * UINT8_COUNT)
+#ifndef FRAMES_MAX
+#define FRAMES_MAX 4096
+#endif
+
+// The mutable A sections of the TriStack and TriFrames start out at these
+// capacities and are grown on demand.
+#define TRISTACK_MIN_CAPACITY (2 * UINT8_COUNT)
+#define TRIFRAMES_MIN_CAPACITY 16
+
+// The number of Values guaranteed to be available above a frame's slotsIndex
+// upon entering it.  (A frame has at most UINT8_COUNT locals, and may push up
+// to UINT8_COUNT operands above them for a call or list literal.)
+#define FRAME_STACK_HEADROOM (2 * UINT8_COUNT)
 
 typedef struct {
   OID<ObjClosure> closure;
@@ -33,6 +44,7 @@ typedef struct {
   cb_offset_t   bbo; // B base offset
   cb_offset_t   cbo; // C base offset
   unsigned int  stackDepth;  // [0, stack_depth-1] are valid entries.
+  unsigned int  acapacity;  // Values which fit in the array at abo.
   unsigned int  abi; // A base index  (mutable region)
   unsigned int  bbi; // B base index
   unsigned int  cbi; // C base index (always 0, really)
@@ -60,11 +72,15 @@ tristack_discardn(TriStack *ts, unsigned int n) {
     ts->abi = ts->stackDepth;
 }
 
+void tristack_grow(TriStack *ts);
+
 extern inline void
 tristack_push(TriStack *ts, Value v) {
-  //CBINT FIXME how to check that there is room to push?  (old code didn't care)
-  // We could make all stack edges be followed by a page which faults and
-  // causes a reallocation of the stack.
+  //NOTE: call() reserves FRAME_STACK_HEADROOM Values upon entering each frame,
+  // so only pathologically nested expressions should ever need to grow here.
+  if (__builtin_expect(!!(ts->stackDepth - ts->abi >= ts->acapacity), 0))
+    tristack_grow(ts);
+  assert(ts->stackDepth - ts->abi < ts->acapacity);
   assert(ts->adirect == static_cast<Value*>(cb_at(thread_cb, ts->abo)));
   ts->adirect[ts->stackDepth - ts->abi] = v;
   ++(ts->stackDepth);
@@ -85,6 +101,7 @@ typedef struct {
   CallFrame    *cdirect;  //Cached pointer to the array at cbo.
   CallFrame    *currentFrame;
   unsigned int  frameCount;  // [0, frameCount-1] are valid entries.
+  unsigned int  acapacity;  // CallFrames which fit in the array at abo.
   cb_offset_t   abo; // A base offset (mutable region)
   cb_offset_t   bbo; // B base offset
   cb_offset_t   cbo; // C base offset